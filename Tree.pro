@@ -2,7 +2,9 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++20
+CONFIG += c++20 thread
+
+include(treeCore.pri)
 
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
@@ -14,10 +16,6 @@ SOURCES += \
     treePainter.cpp
 
 HEADERS += \
-    avlTree.hpp \
-    binaryTree.hpp \
-    binaryTreeNode.hpp \
-    linkedBinaryTree.hpp \
     mainwindow.h \
     treeLocator.hpp \
     treePainter.h
@@ -1,53 +1,136 @@
 #ifndef AVLTREE_H
 #define AVLTREE_H
 
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
 #include "linkedBinaryTree.hpp"
+#include "forkJoin.hpp"
 
-template <typename T>
-class avlTree : public linkedBinaryTree<T>
+template <typename T, typename Alloc = heapAllocator, typename Augment = noAugment>
+class avlTree : public linkedBinaryTree<T, Alloc, Augment>
 {
-    using nodePtr = std::unique_ptr<binaryTreeNode<T>>;
+    using nodePtr = typename binaryTreeNode<T, Alloc, Augment>::nodePtr;
 public:
-    nodePtr& insert(const T, nodePtr&) noexcept override;
-    bool erase(const T, nodePtr&) noexcept override;
-    friend std::istream& operator>> (std::istream& is, avlTree<T>& t) {
+    nodePtr& insert(const T& theElement, nodePtr& t) noexcept override {return insertAt_(theElement, t);}
+    nodePtr& insert(T&& theElement, nodePtr& t) noexcept override {return insertAt_(std::move(theElement), t);}
+    bool erase(const T&, nodePtr&) noexcept override;
+    /*
+     *	split and join, O(log n) each
+     *	split: keep the elements less than the key, move the rest (the key included) into greater
+     *	join: become left + {key} + right, every element of left must be less than the key and every one of right greater
+     *	the trees handed in are left empty (and a previous content of this or greater is dropped)
+     */
+    void split(const T&, avlTree&);
+    void join(avlTree&, const T&, avlTree&);
+    /*
+     *	set operations in O(m log(n / m + 1)) for sizes m <= n, other is left empty
+     *	the halves of big subtrees are merged in parallel on forkJoinPool::instance()
+     *	(only if the allocator is threadSafe, the pool of poolAllocator is not)
+     */
+    void unionWith(avlTree&&) noexcept;
+    void intersect(avlTree&&) noexcept;
+    void difference(avlTree&&) noexcept;
+    void eraseRange(const T&, const T&) noexcept; //erase every element in [lo, hi]
+    /*
+     *	insert or erase a batch of keys at once, return how many were inserted (were not in the tree) or erased
+     *	the batch is sorted once, then merged with the tree in one pass like unionWith / difference:
+     *	the keys are cut by the root key and each part goes down its side, a subtree no key falls into
+     *	is joined back whole, and keys that fall into an empty subtree are built into a balanced one there,
+     *	so the shared part of the paths is visited once, O(m log(n / m + 1)), which is O(n + m) for big batches
+     *	big parts are merged in parallel as in the set operations
+     */
+    std::size_t insertBatch(std::span<const T>);
+    std::size_t eraseBatch(std::span<const T>);
+    //the shape in a snapshot need not be an AVL tree (linkedBinaryTree saves any), so the keys are always rebuilt balanced
+    bool loadSnapshot(const std::string& path, bool = true) override {return linkedBinaryTree<T, Alloc, Augment>::loadSnapshot(path, false);}
+    friend std::istream& operator>> (std::istream& is, avlTree<T, Alloc, Augment>& t) {
         T theElement;
         is >> theElement;
         if (is)
-            t.insert(theElement, t.root());
+            t.insert(std::move(theElement), t.root());
         return is;
     }
 private:
+    //subtrees at least this high are merged in parallel (about 2^12 nodes and more)
+    static constexpr int parallelHeight_ {12};
+    static constexpr bool parallel_ {Alloc::threadSafe};
+    //insert_ and erase_ rebalance the subtree t, insertAt_ and erase then refresh the heights above it
+    template <typename E>
+    nodePtr& insertAt_(E&&, nodePtr&) noexcept;
+    template <typename E>
+    nodePtr& insert_(E&&, nodePtr&) noexcept;
+    bool erase_(const T&, nodePtr&) noexcept;
+    //unlink the node of the maximum (minimum) of t and return its element, moved out, t is rebalanced on the way back
+    T takeMax_(nodePtr&) noexcept;
+    T takeMin_(nodePtr&) noexcept;
+    void rebalance_(nodePtr&) noexcept; //one rotation at t if its children differ in height by 2, else a new height
     nodePtr& SingleRotateWithLeft(nodePtr&, nodePtr&) noexcept;
     nodePtr& SingleRotateWithRight(nodePtr&, nodePtr&) noexcept;
     nodePtr& DoubleRotateWithLeft(nodePtr&) noexcept;
     nodePtr& DoubleRotateWithRight(nodePtr&) noexcept;
+    void expose_(nodePtr&, nodePtr&, nodePtr&) noexcept;
+    void link_(nodePtr&, nodePtr, nodePtr) noexcept;
+    nodePtr join_(nodePtr, nodePtr, nodePtr) noexcept;
+    nodePtr joinRight_(nodePtr, nodePtr, nodePtr) noexcept;
+    nodePtr joinLeft_(nodePtr, nodePtr, nodePtr) noexcept;
+    nodePtr join2_(nodePtr, nodePtr) noexcept;
+    nodePtr splitLast_(nodePtr, nodePtr&) noexcept;
+    nodePtr split_(nodePtr, const T&, nodePtr&, nodePtr&) noexcept;
+    nodePtr union_(nodePtr, nodePtr) noexcept;
+    nodePtr intersect_(nodePtr, nodePtr) noexcept;
+    nodePtr difference_(nodePtr, nodePtr) noexcept;
+    nodePtr insertSorted_(nodePtr, const T*, const T*, std::size_t&) noexcept;
+    nodePtr eraseSorted_(nodePtr, const T*, const T*, std::size_t&) noexcept;
+    nodePtr fromSorted_(const T*, const T*) noexcept;
+    static std::vector<T> sortedBatch_(std::span<const T>);
+    template <typename F1, typename F2>
+    static void fork_(bool, F1&&, F2&&) noexcept;
 };
 
-template <typename T>
-std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::insert(const T theElement, nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+template <typename E>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& avlTree<T, Alloc, Augment>::insertAt_(E&& theElement, nodePtr& t) noexcept
+{
+    auto above {t == nullptr ? nullptr : t->parent_}; //the rotations below keep it as the parent of t
+    insert_(std::forward<E>(theElement), t);
+    this->updatePath(above, nullptr);
+    return t;
+}
+
+/*
+ *	E is const T& or T: an rvalue is moved into the new leaf, so the element is not read after the recursion,
+ *	the rotation is chosen by the heights instead: the grandchild the element went into is the higher one
+ */
+template <typename T, typename Alloc, typename Augment>
+template <typename E>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& avlTree<T, Alloc, Augment>::insert_(E&& theElement, nodePtr& t) noexcept
 {
     if (t == nullptr)
-        t = std::make_unique<binaryTreeNode<T>>(theElement);
+        t = this->makeNode(std::forward<E>(theElement));
     else if (theElement < t->element_) { //insert in the leftChild
-        t->leftChild_ = std::move(insert(theElement, t->leftChild_));
+        t->leftChild_ = std::move(insert_(std::forward<E>(theElement), t->leftChild_));
+        t->leftChild_->parent_ = t.get();
         if (this->height(t->leftChild_) - this->height(t->rightChild_) > 1) { //unbalanced
-            if (theElement < t->leftChild_->element_)
+            if (this->height(t->leftChild_->leftChild_) > this->height(t->leftChild_->rightChild_))
                 t = std::move(SingleRotateWithLeft(t, t->leftChild_));
             else
                 t = std::move(DoubleRotateWithLeft(t));
         }
     }
     else if (t->element_ < theElement) { //insert in the rightChild
-        t->rightChild_ = std::move(insert(theElement, t->rightChild_));
+        t->rightChild_ = std::move(insert_(std::forward<E>(theElement), t->rightChild_));
+        t->rightChild_->parent_ = t.get();
         if (this->height(t->rightChild_) - this->height(t->leftChild_) > 1) {
-            if (t->rightChild_->element_ < theElement)
+            if (this->height(t->rightChild_->rightChild_) > this->height(t->rightChild_->leftChild_))
                 t = std::move(SingleRotateWithRight(t, t->rightChild_));
             else
                 t = std::move(DoubleRotateWithRight(t));
         }
     }
     //else the element was in the AVL tree already
+    this->updateNode(t);
     return t;
 }
 
@@ -62,13 +145,19 @@ std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::insert(const T theElement, nodeP
  *  X      Y                    Y      Z
  *
  */
-template <typename T>
-std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::SingleRotateWithLeft(nodePtr& k2, nodePtr& k1) noexcept
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& avlTree<T, Alloc, Augment>::SingleRotateWithLeft(nodePtr& k2, nodePtr& k1) noexcept
 {
     //tmp for unique_ptr
     auto tmp {std::move(k1)};
+    tmp->parent_ = k2->parent_;
     k2->leftChild_ = std::move(tmp->rightChild_);
+    if (k2->leftChild_ != nullptr)
+        k2->leftChild_->parent_ = k2.get();
+    this->updateNode(k2); //k2 is the lower one now
+    k2->parent_ = tmp.get();
     tmp->rightChild_ = std::move(k2);
+    this->updateNode(tmp);
     k2 = std::move(tmp);
     return k2;
 }
@@ -85,12 +174,18 @@ std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::SingleRotateWithLeft(nodePtr& k2
  *
  */
 
-template <typename T>
-std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::SingleRotateWithRight(nodePtr& k1, nodePtr& k2) noexcept
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& avlTree<T, Alloc, Augment>::SingleRotateWithRight(nodePtr& k1, nodePtr& k2) noexcept
 {
     auto tmp {std::move(k2)};
+    tmp->parent_ = k1->parent_;
     k1->rightChild_ = std::move(tmp->leftChild_);
+    if (k1->rightChild_ != nullptr)
+        k1->rightChild_->parent_ = k1.get();
+    this->updateNode(k1); //k1 is the lower one now
+    k1->parent_ = tmp.get();
     tmp->leftChild_ = std::move(k1);
+    this->updateNode(tmp);
     k1 = std::move(tmp);
     return k1;
 }
@@ -112,8 +207,8 @@ std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::SingleRotateWithRight(nodePtr& k
  *            B        C
  */
 
-template <typename T>
-std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::DoubleRotateWithLeft(nodePtr& k) noexcept
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& avlTree<T, Alloc, Augment>::DoubleRotateWithLeft(nodePtr& k) noexcept
 {
     //k for k3
     k->leftChild_ = std::move(SingleRotateWithRight(k->leftChild_, k->leftChild_->rightChild_));
@@ -137,47 +232,465 @@ std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::DoubleRotateWithLeft(nodePtr& k)
  *        		B        C
  */
 
-template <typename T>
-std::unique_ptr<binaryTreeNode<T>>& avlTree<T>::DoubleRotateWithRight(nodePtr& k) noexcept
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& avlTree<T, Alloc, Augment>::DoubleRotateWithRight(nodePtr& k) noexcept
 {
     //k for k3
     k->rightChild_ = std::move(SingleRotateWithLeft(k->rightChild_, k->rightChild_->leftChild_));
     return SingleRotateWithRight(k, k->rightChild_);
 }
 
-template <typename T>
-bool avlTree<T>::erase(const T theElement, nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+bool avlTree<T, Alloc, Augment>::erase(const T& theElement, nodePtr& t) noexcept
+{
+    auto above {t == nullptr ? nullptr : t->parent_};
+    bool erased {erase_(theElement, t)};
+    if (erased)
+        this->updatePath(above, nullptr);
+    return erased;
+}
+
+template <typename T, typename Alloc, typename Augment>
+bool avlTree<T, Alloc, Augment>::erase_(const T& theElement, nodePtr& t) noexcept
 {
     if (t == nullptr)
         return false;
-    else if (t->element_ == theElement) {
+    bool erased {true};
+    if (t->element_ == theElement) {
         if (t->leftChild_ != nullptr && t->rightChild_ != nullptr) {
-            if (this->height(t->leftChild_) > this->height(t->rightChild_)) { //choose the appropriate branch
-                t->element_ = this->findMax(t->leftChild_)->element_; //lift the maximum element(leaf) in the leftChild
-                return erase(t->element_, t->leftChild_);
-            } else {
-                t->element_ = this->findMin(t->rightChild_)->element_; //lift the minimum element(leaf) in the rightChild
-                return erase(t->element_, t->rightChild_);
-            }
-        } else
-            t = std::move((t->leftChild_ != nullptr) ? t->leftChild_ : t->rightChild_);
-    } else if (theElement < t->element_) {
-        erase(theElement, t->leftChild_);
-        if (this->height(t->rightChild_) - this->height(t->leftChild_) > 1) { //unbalanced
-            if (this->height(t->rightChild_->leftChild_) > this->height(t->rightChild_->rightChild_))
-                t = std::move(DoubleRotateWithRight(t));
+            if (this->height(t->leftChild_) > this->height(t->rightChild_)) //choose the appropriate branch
+                t->element_ = takeMax_(t->leftChild_); //lift the maximum element in the leftChild
             else
-                t = std::move(SingleRotateWithRight(t, t->rightChild_));
+                t->element_ = takeMin_(t->rightChild_); //lift the minimum element in the rightChild
+        } else {
+            this->replaceWithChild(t);
+            return true;
         }
-    } else {
-        erase(theElement, t->rightChild_);
-        if (this->height(t->leftChild_) - this->height(t->rightChild_) > 1) {
-            if (this->height(t->leftChild_->rightChild_) > this->height(t->leftChild_->leftChild_))
-                t = std::move(DoubleRotateWithLeft(t));
-            else
-                t = std::move(SingleRotateWithLeft(t, t->leftChild_));
+    } else if (theElement < t->element_)
+        erased = erase_(theElement, t->leftChild_);
+    else
+        erased = erase_(theElement, t->rightChild_);
+    rebalance_(t);
+    return erased;
+}
+
+template <typename T, typename Alloc, typename Augment>
+T avlTree<T, Alloc, Augment>::takeMax_(nodePtr& t) noexcept
+{
+    if (t->rightChild_ == nullptr) {
+        auto theElement {std::move(t->element_)};
+        this->replaceWithChild(t);
+        return theElement;
+    }
+    auto theElement {takeMax_(t->rightChild_)};
+    rebalance_(t);
+    return theElement;
+}
+
+template <typename T, typename Alloc, typename Augment>
+T avlTree<T, Alloc, Augment>::takeMin_(nodePtr& t) noexcept
+{
+    if (t->leftChild_ == nullptr) {
+        auto theElement {std::move(t->element_)};
+        this->replaceWithChild(t);
+        return theElement;
+    }
+    auto theElement {takeMin_(t->leftChild_)};
+    rebalance_(t);
+    return theElement;
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::rebalance_(nodePtr& t) noexcept
+{
+    //the heights of both children are cached, so every check below is O(1)
+    if (this->height(t->rightChild_) - this->height(t->leftChild_) > 1) { //unbalanced
+        if (this->height(t->rightChild_->leftChild_) > this->height(t->rightChild_->rightChild_))
+            t = std::move(DoubleRotateWithRight(t));
+        else
+            t = std::move(SingleRotateWithRight(t, t->rightChild_));
+    } else if (this->height(t->leftChild_) - this->height(t->rightChild_) > 1) {
+        if (this->height(t->leftChild_->rightChild_) > this->height(t->leftChild_->leftChild_))
+            t = std::move(DoubleRotateWithLeft(t));
+        else
+            t = std::move(SingleRotateWithLeft(t, t->leftChild_));
+    } else
+        this->updateNode(t);
+}
+
+//take the children off t, t is left a lone node and the children are roots of their own
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::expose_(nodePtr& t, nodePtr& left, nodePtr& right) noexcept
+{
+    left = std::move(t->leftChild_);
+    right = std::move(t->rightChild_);
+    if (left != nullptr)
+        left->parent_ = nullptr;
+    if (right != nullptr)
+        right->parent_ = nullptr;
+    t->parent_ = nullptr;
+    this->updateNode(t);
+}
+
+//hang left and right under the lone node k
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::link_(nodePtr& k, nodePtr left, nodePtr right) noexcept
+{
+    k->leftChild_ = std::move(left);
+    if (k->leftChild_ != nullptr)
+        k->leftChild_->parent_ = k.get();
+    k->rightChild_ = std::move(right);
+    if (k->rightChild_ != nullptr)
+        k->rightChild_->parent_ = k.get();
+    this->updateNode(k);
+}
+
+/*
+ *	left + k + right, k is a lone node between them
+ *	if the heights are close, k simply becomes the root
+ *	otherwise k goes down the inner spine of the higher tree to the first subtree no more than one higher
+ *	than the lower tree, takes it with the lower tree as its children, and the way back up is rebalanced
+ *	(with at most one rotation per level), so the cost is O(|height(left) - height(right)| + 1)
+ */
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::join_(nodePtr left, nodePtr k, nodePtr right) noexcept
+{
+    if (this->height(left) > this->height(right) + 1)
+        return joinRight_(std::move(left), std::move(k), std::move(right));
+    if (this->height(right) > this->height(left) + 1)
+        return joinLeft_(std::move(left), std::move(k), std::move(right));
+    link_(k, std::move(left), std::move(right));
+    return k;
+}
+
+//left is the higher one, go down its right spine
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::joinRight_(nodePtr left, nodePtr k, nodePtr right) noexcept
+{
+    auto c {std::move(left->rightChild_)};
+    if (c != nullptr)
+        c->parent_ = nullptr;
+    if (this->height(c) <= this->height(right) + 1) {
+        link_(k, std::move(c), std::move(right));
+        if (this->height(k) > this->height(left->leftChild_) + 1) //k grew too high: double rotation
+            SingleRotateWithLeft(k, k->leftChild_);
+    } else
+        k = joinRight_(std::move(c), std::move(k), std::move(right));
+    link_(left, std::move(left->leftChild_), std::move(k));
+    if (this->height(left->rightChild_) > this->height(left->leftChild_) + 1)
+        SingleRotateWithRight(left, left->rightChild_);
+    return left;
+}
+
+//right is the higher one, go down its left spine
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::joinLeft_(nodePtr left, nodePtr k, nodePtr right) noexcept
+{
+    auto c {std::move(right->leftChild_)};
+    if (c != nullptr)
+        c->parent_ = nullptr;
+    if (this->height(c) <= this->height(left) + 1) {
+        link_(k, std::move(left), std::move(c));
+        if (this->height(k) > this->height(right->rightChild_) + 1)
+            SingleRotateWithRight(k, k->rightChild_);
+    } else
+        k = joinLeft_(std::move(left), std::move(k), std::move(c));
+    link_(right, std::move(k), std::move(right->rightChild_));
+    if (this->height(right->leftChild_) > this->height(right->rightChild_) + 1)
+        SingleRotateWithLeft(right, right->leftChild_);
+    return right;
+}
+
+//take the maximum node of t out as a lone node, return the rest
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::splitLast_(nodePtr t, nodePtr& last) noexcept
+{
+    nodePtr left, right;
+    expose_(t, left, right);
+    if (right == nullptr) {
+        last = std::move(t);
+        return left;
+    }
+    auto rest {splitLast_(std::move(right), last)};
+    return join_(std::move(left), std::move(t), std::move(rest));
+}
+
+//left + right without a middle key
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::join2_(nodePtr left, nodePtr right) noexcept
+{
+    if (left == nullptr)
+        return right;
+    nodePtr last;
+    auto rest {splitLast_(std::move(left), last)};
+    return join_(std::move(rest), std::move(last), std::move(right));
+}
+
+/*
+ *	cut t by theElement: the elements less than it go to left, the greater ones to right
+ *	returns the node holding theElement as a lone node (nullptr if there is none)
+ *	every level joins the side it keeps back on, the joins telescope to O(log n) in total
+ */
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::split_(nodePtr t, const T& theElement, nodePtr& left, nodePtr& right) noexcept
+{
+    if (t == nullptr) {
+        left = nullptr;
+        right = nullptr;
+        return nullptr;
+    }
+    nodePtr tl, tr;
+    expose_(t, tl, tr);
+    if (theElement < t->element_) {
+        nodePtr middle;
+        auto found {split_(std::move(tl), theElement, left, middle)};
+        right = join_(std::move(middle), std::move(t), std::move(tr));
+        return found;
+    }
+    if (t->element_ < theElement) {
+        nodePtr middle;
+        auto found {split_(std::move(tr), theElement, middle, right)};
+        left = join_(std::move(tl), std::move(t), std::move(middle));
+        return found;
+    }
+    left = std::move(tl);
+    right = std::move(tr);
+    return t;
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::split(const T& theElement, avlTree& greater)
+{
+    static_assert(Alloc::releasesInBulk == false, "split hands nodes to another tree, its pool would have to outlive this one");
+    nodePtr left, right;
+    auto found {split_(std::move(this->root()), theElement, left, right)};
+    if (found != nullptr)
+        right = join_(nullptr, std::move(found), std::move(right)); //the key is the minimum of greater
+    this->root() = std::move(left);
+    greater.root() = std::move(right);
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::join(avlTree& left, const T& theElement, avlTree& right)
+{
+    auto k {this->makeNode(theElement)};
+    auto l {std::move(left.root())};
+    auto r {std::move(right.root())};
+    this->adoptPool(left);
+    this->adoptPool(right);
+    this->root() = join_(std::move(l), std::move(k), std::move(r));
+}
+
+//run f1 and f2, in parallel if asked to and the allocator allows it
+template <typename T, typename Alloc, typename Augment>
+template <typename F1, typename F2>
+void avlTree<T, Alloc, Augment>::fork_(bool big, F1&& f1, F2&& f2) noexcept
+{
+    if constexpr (parallel_) {
+        if (big) {
+            forkJoinPool::instance().invoke(std::forward<F1>(f1), std::forward<F2>(f2));
+            return;
+        }
+    }
+    f1();
+    f2();
+}
+
+/*
+ *	the join-based set operations: split the other tree by the root key of one,
+ *	merge the two pairs of halves independently (in parallel), then join the results back on the root
+ */
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::union_(nodePtr t1, nodePtr t2) noexcept
+{
+    if (t1 == nullptr)
+        return t2;
+    if (t2 == nullptr)
+        return t1;
+    bool big {this->height(t1) >= parallelHeight_ && this->height(t2) >= parallelHeight_};
+    nodePtr l1, r1, l2, r2;
+    expose_(t1, l1, r1);
+    split_(std::move(t2), t1->element_, l2, r2); //a duplicate of the key is dropped here
+    nodePtr left, right;
+    fork_(big, [&] {left = union_(std::move(l1), std::move(l2));},
+               [&] {right = union_(std::move(r1), std::move(r2));});
+    return join_(std::move(left), std::move(t1), std::move(right));
+}
+
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::intersect_(nodePtr t1, nodePtr t2) noexcept
+{
+    if (t1 == nullptr || t2 == nullptr)
+        return nullptr;
+    bool big {this->height(t1) >= parallelHeight_ && this->height(t2) >= parallelHeight_};
+    nodePtr l1, r1, l2, r2;
+    expose_(t1, l1, r1);
+    auto found {split_(std::move(t2), t1->element_, l2, r2)};
+    nodePtr left, right;
+    fork_(big, [&] {left = intersect_(std::move(l1), std::move(l2));},
+               [&] {right = intersect_(std::move(r1), std::move(r2));});
+    if (found != nullptr)
+        return join_(std::move(left), std::move(t1), std::move(right));
+    return join2_(std::move(left), std::move(right));
+}
+
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::difference_(nodePtr t1, nodePtr t2) noexcept
+{
+    if (t1 == nullptr || t2 == nullptr)
+        return t1;
+    bool big {this->height(t1) >= parallelHeight_ && this->height(t2) >= parallelHeight_};
+    nodePtr l1, r1, l2, r2;
+    expose_(t2, l2, r2);
+    split_(std::move(t1), t2->element_, l1, r1); //drops the key from t1 if it is there
+    nodePtr left, right;
+    fork_(big, [&] {left = difference_(std::move(l1), std::move(l2));},
+               [&] {right = difference_(std::move(r1), std::move(r2));});
+    return join2_(std::move(left), std::move(right));
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::unionWith(avlTree&& other) noexcept
+{
+    if (&other == this)
+        return;
+    auto t2 {std::move(other.root())};
+    this->adoptPool(other);
+    this->root() = union_(std::move(this->root()), std::move(t2));
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::intersect(avlTree&& other) noexcept
+{
+    if (&other == this)
+        return;
+    auto t2 {std::move(other.root())};
+    this->adoptPool(other);
+    this->root() = intersect_(std::move(this->root()), std::move(t2));
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::difference(avlTree&& other) noexcept
+{
+    if (&other == this) {
+        this->root() = nullptr;
+        return;
+    }
+    auto t2 {std::move(other.root())};
+    this->adoptPool(other);
+    this->root() = difference_(std::move(this->root()), std::move(t2));
+}
+
+template <typename T, typename Alloc, typename Augment>
+void avlTree<T, Alloc, Augment>::eraseRange(const T& lo, const T& hi) noexcept
+{
+    if (hi < lo)
+        return;
+    nodePtr less, rest, middle, greater;
+    split_(std::move(this->root()), lo, less, rest);
+    split_(std::move(rest), hi, middle, greater);
+    //the lone nodes of lo and hi and the middle part are dropped with their unique_ptrs
+    this->root() = join2_(std::move(less), std::move(greater));
+}
+
+template <typename T, typename Alloc, typename Augment>
+std::vector<T> avlTree<T, Alloc, Augment>::sortedBatch_(std::span<const T> keys)
+{
+    std::vector<T> batch(keys.begin(), keys.end());
+    std::sort(batch.begin(), batch.end());
+    batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+    return batch;
+}
+
+template <typename T, typename Alloc, typename Augment>
+std::size_t avlTree<T, Alloc, Augment>::insertBatch(std::span<const T> keys)
+{
+    auto batch {sortedBatch_(keys)};
+    std::size_t inserted {};
+    this->root() = insertSorted_(std::move(this->root()), batch.data(), batch.data() + batch.size(), inserted);
+    return inserted;
+}
+
+template <typename T, typename Alloc, typename Augment>
+std::size_t avlTree<T, Alloc, Augment>::eraseBatch(std::span<const T> keys)
+{
+    if (this->empty())
+        return 0;
+    auto batch {sortedBatch_(keys)};
+    std::size_t erased {};
+    this->root() = eraseSorted_(std::move(this->root()), batch.data(), batch.data() + batch.size(), erased);
+    return erased;
+}
+
+/*
+ *	merge the sorted keys [first, last) into t: cut them by the key of t, merge each part into its side,
+ *	join the sides back on t (a part may be merged in parallel like in union_)
+ */
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::insertSorted_(nodePtr t, const T* first, const T* last, std::size_t& inserted) noexcept
+{
+    if (first == last)
+        return t;
+    if (t == nullptr) {
+        inserted += static_cast<std::size_t>(last - first);
+        return fromSorted_(first, last);
+    }
+    if (last - first == 1) { //a lone key goes down the usual way, cheaper than cutting every subtree on its path
+        auto p {t.get()};
+        while (p != nullptr && (*first < p->element_ || p->element_ < *first))
+            p = *first < p->element_ ? p->leftChild_.get() : p->rightChild_.get();
+        if (p == nullptr) {
+            ++inserted;
+            insert_(*first, t); //t is cut off the tree, there is nothing above it to refresh
         }
+        return t;
+    }
+    bool big {this->height(t) >= parallelHeight_ && last - first >= std::ptrdiff_t{1} << parallelHeight_};
+    nodePtr l, r;
+    expose_(t, l, r);
+    auto middle {std::lower_bound(first, last, t->element_)};
+    auto after {middle != last && !(t->element_ < *middle) ? middle + 1 : middle};
+    std::size_t leftInserted {}, rightInserted {};
+    fork_(big, [&] {l = insertSorted_(std::move(l), first, middle, leftInserted);},
+               [&] {r = insertSorted_(std::move(r), after, last, rightInserted);});
+    inserted += leftInserted + rightInserted;
+    return join_(std::move(l), std::move(t), std::move(r));
+}
+
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::eraseSorted_(nodePtr t, const T* first, const T* last, std::size_t& erased) noexcept
+{
+    if (t == nullptr || first == last)
+        return t;
+    if (last - first == 1) {
+        erased += erase_(*first, t);
+        return t;
     }
-    return true;
+    bool big {this->height(t) >= parallelHeight_ && last - first >= std::ptrdiff_t{1} << parallelHeight_};
+    nodePtr l, r;
+    expose_(t, l, r);
+    auto middle {std::lower_bound(first, last, t->element_)};
+    bool found {middle != last && !(t->element_ < *middle)};
+    std::size_t leftErased {}, rightErased {};
+    fork_(big, [&] {l = eraseSorted_(std::move(l), first, middle, leftErased);},
+               [&] {r = eraseSorted_(std::move(r), middle + found, last, rightErased);});
+    erased += leftErased + rightErased;
+    if (found) {
+        ++erased;
+        return join2_(std::move(l), std::move(r)); //t is dropped
+    }
+    return join_(std::move(l), std::move(t), std::move(r));
+}
+
+//a height-balanced tree of new nodes holding [first, last)
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr avlTree<T, Alloc, Augment>::fromSorted_(const T* first, const T* last) noexcept
+{
+    if (first == last)
+        return nullptr;
+    auto middle {first + (last - first) / 2};
+    auto t {this->makeNode(*middle)};
+    link_(t, fromSorted_(first, middle), fromSorted_(middle + 1, last));
+    return t;
 }
 #endif // AVLTREE_H
@@ -0,0 +1,521 @@
+#ifndef BPLUSTREE_HPP
+#define BPLUSTREE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "binaryTree.hpp"
+
+/*
+ *	the nodes of bPlusTree<T, NodeBytes>, laid out as described there
+ *	room for count_ and next_ (or count_ in front of the children), the rest is keys, a whole number of lanes
+ */
+template <typename T, std::size_t NodeBytes>
+struct bPlusCapacity
+{
+    static constexpr std::size_t lane {std::is_arithmetic_v<T> ? std::max<std::size_t>(16 / sizeof(T), 1) : 1};
+    static constexpr std::uint32_t leaf {static_cast<std::uint32_t>(std::max<std::size_t>(
+        (NodeBytes - 2 * sizeof(void*)) / sizeof(T) / lane * lane, 4))};
+    static constexpr std::uint32_t inner {static_cast<std::uint32_t>(std::max<std::size_t>(
+        (NodeBytes - 2 * sizeof(void*)) / (sizeof(T) + sizeof(void*)) / lane * lane, 4))};
+};
+
+//the elements live in the leaves
+template <typename T, std::size_t NodeBytes>
+struct alignas(64) bPlusLeaf
+{
+    T keys_[bPlusCapacity<T, NodeBytes>::leaf] {}; //initialized, the search reads the unused ones too
+    std::uint32_t count_ {};
+    bPlusLeaf* next_ {nullptr};
+};
+
+template <typename T, std::size_t NodeBytes>
+struct alignas(64) bPlusInner
+{
+    T keys_[bPlusCapacity<T, NodeBytes>::inner] {};
+    std::uint32_t count_ {}; //keys, there is one more child
+    void* children_[bPlusCapacity<T, NodeBytes>::inner + 1]; //inner nodes above the leaf level, leaves on it
+};
+
+/*
+ *	B+ tree: every element sits in a leaf, the inner nodes only route, the leaves are linked in order
+ *	a node is NodeBytes long and starts on a cache line, its keys come first, so the capacities follow from sizeof(T):
+ *
+ *	  leaf   | keys_[leafCapacity_]                      | count_ | next_ |
+ *	  inner  | keys_[innerCapacity_] | count_ | children_[innerCapacity_ + 1] |
+ *
+ *	(for int and 256 bytes: 60 elements in a leaf, 20 keys and 21 children in an inner node)
+ *	a search reads one node per level and counts the keys less than the key in a loop with no branch,
+ *	which compilers vectorize for arithmetic keys; children_[i] holds the keys in [keys_[i - 1], keys_[i])
+ *	every node but the root is at least half full, so the height is O(log n / log(capacity / 2))
+ *	T must be default constructible and copy assignable (the key arrays are plain arrays)
+ *
+ *	the surface is the one of avlTree with a root of its own: insert / erase / find of one key,
+ *	nodeCount is the number of elements (the node count of the binary trees), height counts the levels
+ */
+template <typename T, std::size_t NodeBytes = 256>
+class bPlusTree : public binaryTree<bPlusLeaf<T, NodeBytes>>
+{
+    using leaf = bPlusLeaf<T, NodeBytes>;
+    using inner = bPlusInner<T, NodeBytes>;
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        iterator() = default;
+        reference operator*() const noexcept {return leaf_->keys_[i_];}
+        pointer operator->() const noexcept {return &leaf_->keys_[i_];}
+        iterator& operator++() noexcept
+        {
+            if (++i_ == leaf_->count_) {
+                leaf_ = leaf_->next_;
+                i_ = 0;
+            }
+            return *this;
+        }
+        iterator operator++(int) noexcept
+        {
+            auto old {*this};
+            ++*this;
+            return old;
+        }
+        bool operator==(const iterator& rhs) const noexcept {return leaf_ == rhs.leaf_ && i_ == rhs.i_;}
+    private:
+        const leaf* leaf_ {nullptr}; //nullptr for end()
+        std::uint32_t i_ {};
+        iterator(const leaf* theLeaf, std::uint32_t i) noexcept : leaf_(theLeaf), i_(i) { }
+        friend class bPlusTree;
+    };
+    using const_iterator = iterator;
+
+    bPlusTree() = default;
+    bPlusTree(const bPlusTree& rhs) {build(rhs.begin(), rhs.end());}
+    bPlusTree(bPlusTree&& rhs) noexcept {swap(rhs);}
+    bPlusTree& operator=(bPlusTree rhs) noexcept
+    {
+        swap(rhs);
+        return *this;
+    }
+    ~bPlusTree() {clear();}
+    void swap(bPlusTree& rhs) noexcept
+    {
+        std::swap(root_, rhs.root_);
+        std::swap(height_, rhs.height_);
+        std::swap(size_, rhs.size_);
+        std::swap(first_, rhs.first_);
+    }
+    inline bool empty() const noexcept override {return size_ == 0;}
+    inline int height() noexcept override {return height_;}
+    inline int nodeCount() noexcept override {return static_cast<int>(size_);}
+    inline std::size_t size() const noexcept {return size_;}
+    bool find(const T& theElement) const noexcept {return find_(theElement);}
+    template <typename K> requires transparentKey<K, T>
+    bool find(const K& theKey) const noexcept {return find_(theKey);}
+    bool insert(const T&);
+    bool erase(const T&) noexcept;
+    void clear() noexcept;
+    //replace the content in O(n), the leaves are filled up, [first, last) must be sorted and free of duplicates
+    template <typename ForwardIt>
+    void build(ForwardIt first, ForwardIt last);
+    iterator begin() const noexcept {return iterator(first_, 0);}
+    iterator end() const noexcept {return iterator();}
+    iterator lower_bound(const T& theElement) const noexcept {return lowerBound_(theElement);} //first element not less than the key
+    template <typename K> requires transparentKey<K, T>
+    iterator lower_bound(const K& theKey) const noexcept {return lowerBound_(theKey);}
+    //the elements in order, the visitor sees const T&, see visitNode for the protocol
+    template <typename Visit>
+    bool inOrder(Visit&& theVisit) const
+    {
+        for (auto p = first_; p != nullptr; p = p->next_)
+            for (std::uint32_t i = 0; i != p->count_; ++i)
+                if (!visitNode(theVisit, p->keys_[i]))
+                    return false;
+        return true;
+    }
+private:
+    static constexpr std::uint32_t leafCapacity_ {bPlusCapacity<T, NodeBytes>::leaf};
+    static constexpr std::uint32_t innerCapacity_ {bPlusCapacity<T, NodeBytes>::inner};
+    static constexpr std::uint32_t leafMin_ {leafCapacity_ / 2};
+    static constexpr std::uint32_t innerMin_ {(innerCapacity_ - 1) / 2}; //a split leaves one key fewer on the right
+    void* root_ {nullptr}; //a leaf if height_ is 1
+    int height_ {}; //levels, 0 for an empty tree
+    std::size_t size_ {};
+    leaf* first_ {nullptr}; //the leftmost leaf
+    /*
+     *	the number of keys less than the key (lower) or not greater than it (upper) among keys[0, count)
+     *	arithmetic keys are compared over the whole array (capacity is a multiple of the 16-byte lanes),
+     *	the unused tail is masked off, a loop of known length that compilers vectorize at -O2 already
+     */
+    template <std::uint32_t Capacity, typename K>
+    static std::uint32_t lower_(const T* keys, std::uint32_t count, const K& theElement) noexcept
+    {
+        std::uint32_t i {};
+        if constexpr (std::is_arithmetic_v<T>)
+            for (std::uint32_t j = 0; j != Capacity; ++j)
+                i += (j < count) & (keys[j] < theElement);
+        else
+            for (std::uint32_t j = 0; j != count; ++j)
+                i += keys[j] < theElement;
+        return i;
+    }
+    template <std::uint32_t Capacity, typename K>
+    static std::uint32_t upper_(const T* keys, std::uint32_t count, const K& theElement) noexcept
+    {
+        std::uint32_t i {};
+        if constexpr (std::is_arithmetic_v<T>)
+            for (std::uint32_t j = 0; j != Capacity; ++j)
+                i += (j < count) & !(theElement < keys[j]);
+        else
+            for (std::uint32_t j = 0; j != count; ++j)
+                i += !(theElement < keys[j]);
+        return i;
+    }
+    template <typename K>
+    const leaf* leafOf_(const K&) const noexcept;
+    template <typename K>
+    bool find_(const K&) const noexcept;
+    template <typename K>
+    iterator lowerBound_(const K&) const noexcept;
+    bool insert_(void*, int, const T&, void*&, T&);
+    bool erase_(void*, int, const T&) noexcept;
+    void fixChild_(inner*, std::uint32_t, int) noexcept;
+    static void clear_(void*, int) noexcept;
+};
+
+//the leaf whose range holds the key
+template <typename T, std::size_t NodeBytes>
+template <typename K>
+typename bPlusTree<T, NodeBytes>::leaf const* bPlusTree<T, NodeBytes>::leafOf_(const K& theElement) const noexcept
+{
+    auto p {root_};
+    for (int level = height_; level > 1; --level) {
+        auto in {static_cast<const inner*>(p)};
+        p = in->children_[upper_<innerCapacity_>(in->keys_, in->count_, theElement)];
+    }
+    return static_cast<const leaf*>(p);
+}
+
+//K is T or a transparentKey
+template <typename T, std::size_t NodeBytes>
+template <typename K>
+bool bPlusTree<T, NodeBytes>::find_(const K& theElement) const noexcept
+{
+    if (root_ == nullptr)
+        return false;
+    auto p {leafOf_(theElement)};
+    auto i {lower_<leafCapacity_>(p->keys_, p->count_, theElement)};
+    return i != p->count_ && !(theElement < p->keys_[i]);
+}
+
+template <typename T, std::size_t NodeBytes>
+template <typename K>
+typename bPlusTree<T, NodeBytes>::iterator bPlusTree<T, NodeBytes>::lowerBound_(const K& theElement) const noexcept
+{
+    if (root_ == nullptr)
+        return end();
+    auto p {leafOf_(theElement)};
+    auto i {lower_<leafCapacity_>(p->keys_, p->count_, theElement)};
+    if (i == p->count_) //every key of this leaf is less, the answer begins the next one
+        return iterator(p->next_, 0);
+    return iterator(p, i);
+}
+
+template <typename T, std::size_t NodeBytes>
+bool bPlusTree<T, NodeBytes>::insert(const T& theElement)
+{
+    if (root_ == nullptr) {
+        auto p {new leaf};
+        p->keys_[0] = theElement;
+        p->count_ = 1;
+        root_ = first_ = p;
+        height_ = 1;
+        size_ = 1;
+        return true;
+    }
+    void* split {nullptr};
+    T separator {};
+    if (!insert_(root_, height_, theElement, split, separator))
+        return false;
+    ++size_;
+    if (split != nullptr) { //the root split: one level more
+        auto r {new inner};
+        r->keys_[0] = separator;
+        r->children_[0] = root_;
+        r->children_[1] = split;
+        r->count_ = 1;
+        root_ = r;
+        ++height_;
+    }
+    return true;
+}
+
+/*
+ *	insert below p (level 1 is a leaf), a full node is split in halves on the way back up:
+ *	split is the new right half then, and separator the smallest key below it
+ */
+template <typename T, std::size_t NodeBytes>
+bool bPlusTree<T, NodeBytes>::insert_(void* p, int level, const T& theElement, void*& split, T& separator)
+{
+    if (level == 1) {
+        auto l {static_cast<leaf*>(p)};
+        auto i {lower_<leafCapacity_>(l->keys_, l->count_, theElement)};
+        if (i != l->count_ && !(theElement < l->keys_[i]))
+            return false;
+        if (l->count_ == leafCapacity_) {
+            auto right {new leaf};
+            constexpr auto half {leafCapacity_ / 2};
+            std::move(l->keys_ + half, l->keys_ + leafCapacity_, right->keys_);
+            right->count_ = leafCapacity_ - half;
+            l->count_ = half;
+            right->next_ = l->next_;
+            l->next_ = right;
+            split = right;
+            if (i > half) {
+                l = right;
+                i -= half;
+            }
+        }
+        std::move_backward(l->keys_ + i, l->keys_ + l->count_, l->keys_ + l->count_ + 1);
+        l->keys_[i] = theElement;
+        ++l->count_;
+        if (split != nullptr)
+            separator = static_cast<leaf*>(split)->keys_[0];
+        return true;
+    }
+    auto in {static_cast<inner*>(p)};
+    auto i {upper_<innerCapacity_>(in->keys_, in->count_, theElement)};
+    void* childSplit {nullptr};
+    T childSeparator {};
+    if (!insert_(in->children_[i], level - 1, theElement, childSplit, childSeparator))
+        return false;
+    if (childSplit == nullptr)
+        return true;
+    if (in->count_ == innerCapacity_) { //split first: the middle key goes up, the halves keep the ones around it
+        auto right {new inner};
+        constexpr auto half {innerCapacity_ / 2};
+        separator = in->keys_[half];
+        std::move(in->keys_ + half + 1, in->keys_ + innerCapacity_, right->keys_);
+        std::copy(in->children_ + half + 1, in->children_ + innerCapacity_ + 1, right->children_);
+        right->count_ = innerCapacity_ - half - 1;
+        in->count_ = half;
+        split = right;
+        if (i > half) {
+            in = right;
+            i -= half + 1;
+        }
+    }
+    std::move_backward(in->keys_ + i, in->keys_ + in->count_, in->keys_ + in->count_ + 1);
+    std::copy_backward(in->children_ + i + 1, in->children_ + in->count_ + 1, in->children_ + in->count_ + 2);
+    in->keys_[i] = childSeparator;
+    in->children_[i + 1] = childSplit;
+    ++in->count_;
+    return true;
+}
+
+template <typename T, std::size_t NodeBytes>
+bool bPlusTree<T, NodeBytes>::erase(const T& theElement) noexcept
+{
+    if (root_ == nullptr || !erase_(root_, height_, theElement))
+        return false;
+    --size_;
+    if (height_ == 1) {
+        if (static_cast<leaf*>(root_)->count_ == 0) {
+            delete static_cast<leaf*>(root_);
+            root_ = first_ = nullptr;
+            height_ = 0;
+        }
+    } else if (auto r {static_cast<inner*>(root_)}; r->count_ == 0) { //one child left: one level less
+        root_ = r->children_[0];
+        delete r;
+        --height_;
+    }
+    return true;
+}
+
+//erase below p, a child left less than half full is refilled on the way back up (see fixChild_)
+template <typename T, std::size_t NodeBytes>
+bool bPlusTree<T, NodeBytes>::erase_(void* p, int level, const T& theElement) noexcept
+{
+    if (level == 1) {
+        auto l {static_cast<leaf*>(p)};
+        auto i {lower_<leafCapacity_>(l->keys_, l->count_, theElement)};
+        if (i == l->count_ || theElement < l->keys_[i])
+            return false;
+        std::move(l->keys_ + i + 1, l->keys_ + l->count_, l->keys_ + i);
+        --l->count_;
+        return true;
+    }
+    auto in {static_cast<inner*>(p)};
+    auto i {upper_<innerCapacity_>(in->keys_, in->count_, theElement)};
+    if (!erase_(in->children_[i], level - 1, theElement))
+        return false;
+    fixChild_(in, i, level - 1);
+    return true;
+}
+
+/*
+ *	children_[i] of in (on level) may have dropped below half full:
+ *	borrow one entry from a sibling that can spare it, else merge with a sibling (in loses a key and a child)
+ *	the separator keys of in move along, so every one stays the smallest key of the subtree to its right
+ */
+template <typename T, std::size_t NodeBytes>
+void bPlusTree<T, NodeBytes>::fixChild_(inner* in, std::uint32_t i, int level) noexcept
+{
+    if (level == 1) {
+        auto c {static_cast<leaf*>(in->children_[i])};
+        if (c->count_ >= leafMin_)
+            return;
+        if (i != 0) {
+            if (auto left {static_cast<leaf*>(in->children_[i - 1])}; left->count_ > leafMin_) {
+                std::move_backward(c->keys_, c->keys_ + c->count_, c->keys_ + c->count_ + 1);
+                c->keys_[0] = left->keys_[--left->count_];
+                ++c->count_;
+                in->keys_[i - 1] = c->keys_[0];
+                return;
+            }
+        }
+        if (i != in->count_) {
+            if (auto right {static_cast<leaf*>(in->children_[i + 1])}; right->count_ > leafMin_) {
+                c->keys_[c->count_++] = right->keys_[0];
+                std::move(right->keys_ + 1, right->keys_ + right->count_, right->keys_);
+                --right->count_;
+                in->keys_[i] = right->keys_[0];
+                return;
+            }
+        }
+        auto j {i != 0 ? i - 1 : i}; //merge children_[j + 1] into children_[j]
+        auto l {static_cast<leaf*>(in->children_[j])};
+        auto r {static_cast<leaf*>(in->children_[j + 1])};
+        std::move(r->keys_, r->keys_ + r->count_, l->keys_ + l->count_);
+        l->count_ += r->count_;
+        l->next_ = r->next_;
+        delete r;
+        std::move(in->keys_ + j + 1, in->keys_ + in->count_, in->keys_ + j);
+        std::copy(in->children_ + j + 2, in->children_ + in->count_ + 1, in->children_ + j + 1);
+        --in->count_;
+        return;
+    }
+    auto c {static_cast<inner*>(in->children_[i])};
+    if (c->count_ >= innerMin_)
+        return;
+    if (i != 0) {
+        if (auto left {static_cast<inner*>(in->children_[i - 1])}; left->count_ > innerMin_) {
+            std::move_backward(c->keys_, c->keys_ + c->count_, c->keys_ + c->count_ + 1);
+            std::copy_backward(c->children_, c->children_ + c->count_ + 1, c->children_ + c->count_ + 2);
+            c->keys_[0] = in->keys_[i - 1];
+            c->children_[0] = left->children_[left->count_];
+            ++c->count_;
+            in->keys_[i - 1] = left->keys_[--left->count_];
+            return;
+        }
+    }
+    if (i != in->count_) {
+        if (auto right {static_cast<inner*>(in->children_[i + 1])}; right->count_ > innerMin_) {
+            c->keys_[c->count_] = in->keys_[i];
+            c->children_[++c->count_] = right->children_[0];
+            in->keys_[i] = right->keys_[0];
+            std::move(right->keys_ + 1, right->keys_ + right->count_, right->keys_);
+            std::copy(right->children_ + 1, right->children_ + right->count_ + 1, right->children_);
+            --right->count_;
+            return;
+        }
+    }
+    auto j {i != 0 ? i - 1 : i};
+    auto l {static_cast<inner*>(in->children_[j])};
+    auto r {static_cast<inner*>(in->children_[j + 1])};
+    l->keys_[l->count_] = in->keys_[j]; //the separator comes down between the two halves
+    std::move(r->keys_, r->keys_ + r->count_, l->keys_ + l->count_ + 1);
+    std::copy(r->children_, r->children_ + r->count_ + 1, l->children_ + l->count_ + 1);
+    l->count_ += r->count_ + 1;
+    delete r;
+    std::move(in->keys_ + j + 1, in->keys_ + in->count_, in->keys_ + j);
+    std::copy(in->children_ + j + 2, in->children_ + in->count_ + 1, in->children_ + j + 1);
+    --in->count_;
+}
+
+template <typename T, std::size_t NodeBytes>
+void bPlusTree<T, NodeBytes>::clear() noexcept
+{
+    clear_(root_, height_);
+    root_ = first_ = nullptr;
+    height_ = 0;
+    size_ = 0;
+}
+
+template <typename T, std::size_t NodeBytes>
+void bPlusTree<T, NodeBytes>::clear_(void* p, int level) noexcept
+{
+    if (p == nullptr)
+        return;
+    if (level == 1) {
+        delete static_cast<leaf*>(p);
+        return;
+    }
+    auto in {static_cast<inner*>(p)};
+    for (std::uint32_t i = 0; i != in->count_ + 1; ++i)
+        clear_(in->children_[i], level - 1);
+    delete in;
+}
+
+/*
+ *	bottom up: the elements are dealt out to as few leaves as possible, evenly, so none is less than half full,
+ *	then every level above deals out the nodes below it the same way, until one node is left
+ */
+template <typename T, std::size_t NodeBytes>
+template <typename ForwardIt>
+void bPlusTree<T, NodeBytes>::build(ForwardIt first, ForwardIt last)
+{
+    clear();
+    auto n {static_cast<std::size_t>(std::distance(first, last))};
+    if (n == 0)
+        return;
+    std::vector<void*> level; //the nodes of the level just built, in order
+    std::vector<T> low; //the smallest key below each of them
+    auto leaves {(n + leafCapacity_ - 1) / leafCapacity_};
+    leaf* previous {nullptr};
+    for (std::size_t k = 0; k != leaves; ++k) {
+        auto p {new leaf};
+        p->count_ = static_cast<std::uint32_t>(n * (k + 1) / leaves - n * k / leaves);
+        for (std::uint32_t i = 0; i != p->count_; ++i, ++first)
+            p->keys_[i] = *first;
+        (previous == nullptr ? first_ : previous->next_) = p;
+        previous = p;
+        level.push_back(p);
+        low.push_back(p->keys_[0]);
+    }
+    height_ = 1;
+    while (level.size() > 1) {
+        std::vector<void*> upper;
+        std::vector<T> upperLow;
+        auto m {level.size()};
+        auto parents {(m + innerCapacity_) / (innerCapacity_ + 1)};
+        for (std::size_t k = 0, c = 0; k != parents; ++k) {
+            auto p {new inner};
+            auto children {static_cast<std::uint32_t>(m * (k + 1) / parents - m * k / parents)};
+            p->count_ = children - 1;
+            upperLow.push_back(low[c]);
+            for (std::uint32_t i = 0; i != children; ++i, ++c) {
+                p->children_[i] = level[c];
+                if (i != 0)
+                    p->keys_[i - 1] = low[c];
+            }
+            upper.push_back(p);
+        }
+        level.swap(upper);
+        low.swap(upperLow);
+        ++height_;
+    }
+    root_ = level[0];
+    size_ = n;
+}
+
+#endif // BPLUSTREE_HPP
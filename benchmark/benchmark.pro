@@ -0,0 +1,14 @@
+# headless benchmark of the tree containers, no Qt modules needed
+# qmake benchmark.pro && make && ./treeBench --format csv --out bench.csv
+# (qmake CONFIG+=avx2 benchmark.pro for the AVX2 frozenFindBatch, see treeCore.pri)
+
+TEMPLATE = app
+TARGET = treeBench
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(../treeCore.pri)
+
+SOURCES += \
+    treeBench.cpp
@@ -0,0 +1,960 @@
+#include "avlTree.hpp"
+#include "bPlusTree.hpp"
+#include "concurrentAvlTree.hpp"
+#include "linkedBinaryTree.hpp"
+#include "rcuAvlTree.hpp"
+#include "redBlackTree.hpp"
+#include "seqBinaryTree.hpp"
+#include "splayTree.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ *	headless benchmark of the tree containers, std::set is the reference
+ *	every (container, operation, key pattern, size, threads, batch) is run --repeat times and the median is reported
+ *	batch is the number of keys per call of the batch operations (and of the loops they are compared with), 0 elsewhere
+ *	allocsPerOp is the number of operator new calls per operation, counted for the std::string rows only (empty elsewhere)
+ *	--stress N runs the multi-threaded check of concurrentAvlTree instead (N operations per thread),
+ *	and checks the red-black trees built through linkedBinaryTree, a plain tree degenerated into a deep chain
+ *	and the batch lookup of frozenTree
+ *
+ *	usage: treeBench [--format json|csv] [--sizes 1000,10000,...] [--repeat N] [--threads N] [--out file]
+ *	       treeBench --stress N [--threads N]
+ */
+
+std::uint64_t sink {}; //results of the timed loops go here, so they are not optimized away
+thread_local std::uint64_t allocations {}; //operator new calls of this thread
+
+//every allocation of the program is counted, per thread, so the counting costs no shared write
+//(not inlined: GCC would see the malloc behind new and warn about every delete of it)
+[[gnu::noinline]] void* operator new(std::size_t n)
+{
+    ++allocations;
+    if (auto p {std::malloc(n == 0 ? 1 : n)})
+        return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void* p) noexcept {std::free(p);}
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept {std::free(p);}
+
+namespace {
+
+using clockType = std::chrono::steady_clock;
+
+struct result
+{
+    std::string container;
+    std::string operation;
+    std::string pattern;
+    std::size_t size;
+    double nsPerOp; //median over the repeats, wall time over all threads
+    double totalMs; //median time of the whole operation
+    unsigned threads;
+    std::size_t batch;
+    double allocsPerOp; //negative if not counted
+};
+
+struct options
+{
+    std::string format {"json"};
+    std::vector<std::size_t> sizes {1000, 10000, 100000, 1000000};
+    int repeat {5};
+    unsigned threads {std::max(std::thread::hardware_concurrency(), 2u)}; //the most threads for the scaling runs
+    int stress {}; //operations per thread of the stress check, 0 for none
+    std::string out;
+};
+
+/*
+ *	key patterns, every one is a permutation or a sample of [0, n)
+ *	random: shuffled, sequential: ascending, skewed: most keys are small (u^3 scaled), so many repeat
+ */
+std::vector<int> makeKeys(const std::string& pattern, std::size_t n, std::uint32_t seed)
+{
+    std::vector<int> keys(n);
+    std::mt19937 gen(seed);
+    if (pattern == "skewed") {
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        for (auto& k : keys)
+            k = static_cast<int>(std::pow(u(gen), 3.0) * static_cast<double>(n));
+        return keys;
+    }
+    std::iota(keys.begin(), keys.end(), 0);
+    if (pattern == "random")
+        std::shuffle(keys.begin(), keys.end(), gen);
+    return keys;
+}
+
+/*
+ *	a lookup trace of count keys of [0, n): uniform, or zipf (Zipf(0.99) over the ranks, the ranks given to the keys
+ *	in shuffled order, so the hot keys are spread over the tree), the rank r is drawn with the probability (r + 1)^-0.99 / H
+ */
+std::vector<int> makeTrace(const std::string& pattern, std::size_t n, std::size_t count, std::uint32_t seed)
+{
+    std::mt19937 gen(seed);
+    std::vector<int> trace(count);
+    if (pattern == "uniform") {
+        for (auto& k : trace)
+            k = static_cast<int>(gen() % n);
+        return trace;
+    }
+    std::vector<double> cdf(n);
+    double sum {};
+    for (std::size_t r = 0; r != n; ++r)
+        cdf[r] = sum += std::pow(static_cast<double>(r + 1), -0.99);
+    auto keys {makeKeys("random", n, seed + 1)};
+    std::uniform_real_distribution<double> u(0.0, sum);
+    for (auto& k : trace) {
+        auto r {std::lower_bound(cdf.begin(), cdf.end(), u(gen)) - cdf.begin()};
+        k = keys[static_cast<std::size_t>(std::min<std::ptrdiff_t>(r, static_cast<std::ptrdiff_t>(n) - 1))];
+    }
+    return trace;
+}
+
+//the same calls for every container
+template <typename Tree>
+void insertKey(Tree& t, int k) {t.insert(k, t.root());}
+void insertKey(std::set<int>& t, int k) {t.insert(k);}
+void insertKey(bPlusTree<int>& t, int k) {t.insert(k);}
+template <typename Tree>
+void eraseKey(Tree& t, int k) {t.erase(k, t.root());}
+void eraseKey(std::set<int>& t, int k) {t.erase(k);}
+void eraseKey(bPlusTree<int>& t, int k) {t.erase(k);}
+template <typename Tree>
+bool findKey(Tree& t, int k) {return t.find(k);}
+bool findKey(std::set<int>& t, int k) {return t.find(k) != t.end();}
+template <typename Tree>
+int countOf(Tree& t) {return t.nodeCount();}
+int countOf(std::set<int>& t) {return static_cast<int>(t.size());}
+//the binary trees run the node walks and the frozen copy too, the others only what every container has
+template <typename Tree>
+constexpr bool isBinary {!std::is_same_v<Tree, std::set<int>> && !std::is_same_v<Tree, bPlusTree<int>>};
+
+/*
+ *	the baseline for concurrent use: one avlTree behind one mutex
+ *	the sizes tell whether insert added the key, nodeCount is O(1) with them, so the lock covers one descent
+ *	(the recursive insert refreshes every node on its path anyway, a size costs it next to nothing)
+ */
+class lockedAvlTree
+{
+public:
+    bool insert(int k)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto before {tree_.nodeCount()};
+        tree_.insert(k, tree_.root());
+        return tree_.nodeCount() != before;
+    }
+    bool erase(int k)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tree_.erase(k, tree_.root());
+    }
+    bool find(int k)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tree_.find(k);
+    }
+private:
+    std::mutex mutex_;
+    avlTree<int, heapAllocator, sizeAugment> tree_;
+};
+
+template <typename F>
+double timeMs(F&& f)
+{
+    auto start {clockType::now()};
+    f();
+    return std::chrono::duration<double, std::milli>(clockType::now() - start).count();
+}
+
+class bench
+{
+public:
+    explicit bench(const options& opt) : opt_(opt) { }
+    const std::vector<result>& results() const noexcept {return results_;}
+    template <typename Tree>
+    void run(const std::string& container, std::size_t maxSequential = SIZE_MAX);
+    void runSeq();
+    template <typename Tree>
+    void runScaling(const std::string& container);
+    template <typename Tree>
+    void runReaders(const std::string& container);
+    template <typename Tree>
+    void runMix(const std::string& container);
+    template <typename Tree>
+    void runTrace(const std::string& container);
+    template <typename Tree>
+    void runStrings(const std::string& container);
+    template <typename Tree>
+    void runSnapshot(const std::string& container, bool withShape);
+    void runBatch();
+private:
+    const options& opt_;
+    std::vector<result> results_;
+    //samples[i] is the time of repeat i, ops the operation count of one repeat
+    void add(const std::string& container, const std::string& operation, const std::string& pattern,
+             std::size_t n, std::vector<double>& samples, std::size_t ops)
+    {
+        std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+        auto median {samples[samples.size() / 2]};
+        results_.push_back({container, operation, pattern, n, median * 1e6 / static_cast<double>(std::max<std::size_t>(ops, 1)), median, threads, batch, -1.0});
+    }
+    //the same with the allocations of the last repeat
+    void add(const std::string& container, const std::string& operation, const std::string& pattern,
+             std::size_t n, std::vector<double>& samples, std::size_t ops, std::uint64_t allocs)
+    {
+        add(container, operation, pattern, n, samples, ops);
+        results_.back().allocsPerOp = static_cast<double>(allocs) / static_cast<double>(std::max<std::size_t>(ops, 1));
+    }
+    unsigned threads {1}; //of the results added next
+    std::size_t batch {};
+};
+
+/*
+ *	one round per repeat: insert every key, find every key, walk, query, freeze and find every key
+ *	in the frozen copy, copy, then erase every key
+ *	the plain search tree degenerates on sequential keys (O(n) deep, so n inserts take O(n^2)),
+ *	so that pattern only runs up to maxSequential for it
+ */
+template <typename Tree>
+void bench::run(const std::string& container, std::size_t maxSequential)
+{
+    for (const std::string pattern : {"random", "sequential", "skewed"}) {
+        for (auto n : opt_.sizes) {
+            if (pattern == "sequential" && n > maxSequential)
+                continue;
+            auto keys {makeKeys(pattern, n, static_cast<std::uint32_t>(n))};
+            auto probes {keys};
+            std::shuffle(probes.begin(), probes.end(), std::mt19937(7));
+            std::vector<double> insertMs, findMs, eraseMs, copyMs, countMs;
+            std::vector<double> walkMs[4], heightMs, levelInfoMs, freezeMs, frozenFindMs, frozenBatchMs;
+            std::size_t queryLoops {std::max<std::size_t>(1, 1000000 / n)};
+            for (int r = 0; r != opt_.repeat; ++r) {
+                Tree t;
+                insertMs.push_back(timeMs([&] {
+                    for (auto k : keys)
+                        insertKey(t, k);
+                }));
+                findMs.push_back(timeMs([&] {
+                    for (auto k : probes)
+                        sink += findKey(t, k);
+                }));
+                countMs.push_back(timeMs([&] {
+                    for (std::size_t i = 0; i != queryLoops; ++i)
+                        sink += countOf(t);
+                }));
+                if constexpr (!isBinary<Tree>) {
+                    walkMs[1].push_back(timeMs([&] {
+                        for (auto k : t)
+                            sink += k;
+                    }));
+                } else {
+                    auto visit {[](auto& p) {sink += p.element_;}};
+                    walkMs[0].push_back(timeMs([&] {t.preOrder(visit);}));
+                    walkMs[1].push_back(timeMs([&] {t.inOrder(visit);}));
+                    walkMs[2].push_back(timeMs([&] {t.postOrder(visit);}));
+                    walkMs[3].push_back(timeMs([&] {t.levelOrder(visit);}));
+                    heightMs.push_back(timeMs([&] {
+                        for (std::size_t i = 0; i != queryLoops; ++i)
+                            sink += t.height();
+                    }));
+                    levelInfoMs.push_back(timeMs([&] {sink += t.levelInfo().size();}));
+                    frozenTree<int> frozen;
+                    freezeMs.push_back(timeMs([&] {frozen = t.freeze();}));
+                    frozenFindMs.push_back(timeMs([&] {
+                        for (auto k : probes)
+                            sink += frozen.contains(k);
+                    }));
+                    auto found {std::make_unique<bool[]>(n)};
+                    frozenBatchMs.push_back(timeMs([&] {
+                        frozen.contains(probes.data(), n, found.get());
+                        sink += found[n - 1];
+                    }));
+                }
+                copyMs.push_back(timeMs([&] {
+                    Tree copy(t);
+                    sink += countOf(copy);
+                }));
+                eraseMs.push_back(timeMs([&] {
+                    for (auto k : probes)
+                        eraseKey(t, k);
+                }));
+            }
+            add(container, "insert", pattern, n, insertMs, n);
+            add(container, "find", pattern, n, findMs, n);
+            add(container, "erase", pattern, n, eraseMs, n);
+            add(container, "copy", pattern, n, copyMs, n);
+            add(container, "nodeCount", pattern, n, countMs, queryLoops);
+            add(container, "inOrder", pattern, n, walkMs[1], n);
+            if constexpr (isBinary<Tree>) {
+                add(container, "preOrder", pattern, n, walkMs[0], n);
+                add(container, "postOrder", pattern, n, walkMs[2], n);
+                add(container, "levelOrder", pattern, n, walkMs[3], n);
+                add(container, "height", pattern, n, heightMs, queryLoops);
+                add(container, "levelInfo", pattern, n, levelInfoMs, n);
+                add(container, "freeze", pattern, n, freezeMs, n);
+                add(container, "frozenFind", pattern, n, frozenFindMs, n);
+                add(container, "frozenFindBatch", pattern, n, frozenBatchMs, n);
+            }
+        }
+    }
+}
+
+//the sequential tree is built from a complete level-order array, or flattened from an avlTree and rebuilt into one
+void bench::runSeq()
+{
+    for (auto n : opt_.sizes) {
+        std::vector<int> values(n);
+        std::iota(values.begin(), values.end(), 0);
+        avlTree<int> source;
+        source.build(values.begin(), values.end());
+        std::vector<double> buildMs, walkMs[4], heightMs, countMs, fromTreeMs, toTreeMs;
+        for (int r = 0; r != opt_.repeat; ++r) {
+            std::unique_ptr<seqBinaryTree<int>> t;
+            buildMs.push_back(timeMs([&] {t = std::make_unique<seqBinaryTree<int>>(values);}));
+            auto visit {[](int& p) {sink += p;}};
+            walkMs[0].push_back(timeMs([&] {t->preOrder(visit);}));
+            walkMs[1].push_back(timeMs([&] {t->inOrder(visit);}));
+            walkMs[2].push_back(timeMs([&] {t->postOrder(visit);}));
+            walkMs[3].push_back(timeMs([&] {t->levelOrder(visit);}));
+            heightMs.push_back(timeMs([&] {sink += t->height();}));
+            countMs.push_back(timeMs([&] {sink += t->nodeCount();}));
+            fromTreeMs.push_back(timeMs([&] {t = std::make_unique<seqBinaryTree<int>>(source);}));
+            toTreeMs.push_back(timeMs([&] {
+                avlTree<int> rebuilt;
+                t->toTree(rebuilt);
+                sink += rebuilt.height();
+            }));
+        }
+        add("seqBinaryTree", "build", "complete", n, buildMs, n);
+        add("seqBinaryTree", "preOrder", "complete", n, walkMs[0], n);
+        add("seqBinaryTree", "inOrder", "complete", n, walkMs[1], n);
+        add("seqBinaryTree", "postOrder", "complete", n, walkMs[2], n);
+        add("seqBinaryTree", "levelOrder", "complete", n, walkMs[3], n);
+        add("seqBinaryTree", "height", "complete", n, heightMs, 1);
+        add("seqBinaryTree", "nodeCount", "complete", n, countMs, 1);
+        add("seqBinaryTree", "fromTree", "complete", n, fromTreeMs, n);
+        add("seqBinaryTree", "toTree", "complete", n, toTreeMs, n);
+    }
+}
+
+/*
+ *	insertBatch / eraseBatch of avlTree against a loop of single calls on the same keys,
+ *	batches of 10, 100, ... 10^6 random keys of [0, 2n) on a tree prefilled with every other key of [0, 2n)
+ */
+void bench::runBatch()
+{
+    for (auto n : opt_.sizes) {
+        avlTree<int> source;
+        std::vector<int> prefill;
+        for (std::size_t k = 0; k < 2 * n; k += 2)
+            prefill.push_back(static_cast<int>(k));
+        source.build(prefill.begin(), prefill.end());
+        for (std::size_t m = 10; m <= 1000000; m *= 10) {
+            std::vector<int> keys(m);
+            std::mt19937 gen(static_cast<std::uint32_t>(m));
+            for (auto& k : keys)
+                k = static_cast<int>(gen() % (2 * n));
+            std::vector<double> samples[4];
+            for (int r = 0; r != opt_.repeat; ++r) {
+                auto t {std::make_unique<avlTree<int>>(source)};
+                samples[0].push_back(timeMs([&] {sink += t->insertBatch(keys);}));
+                t = std::make_unique<avlTree<int>>(source);
+                samples[1].push_back(timeMs([&] {
+                    for (auto k : keys)
+                        t->insert(k, t->root());
+                }));
+                t = std::make_unique<avlTree<int>>(source);
+                samples[2].push_back(timeMs([&] {sink += t->eraseBatch(keys);}));
+                t = std::make_unique<avlTree<int>>(source);
+                samples[3].push_back(timeMs([&] {
+                    for (auto k : keys)
+                        sink += t->erase(k, t->root());
+                }));
+            }
+            batch = m;
+            add("avlTree", "insertBatch", "random", n, samples[0], m);
+            add("avlTree", "insertLoop", "random", n, samples[1], m);
+            add("avlTree", "eraseBatch", "random", n, samples[2], m);
+            add("avlTree", "eraseLoop", "random", n, samples[3], m);
+        }
+    }
+    batch = 0;
+}
+
+/*
+ *	one thread, a tree prefilled with every other key of [0, 2n), then a fixed number of random operations
+ *	in three ratios of find : insert : erase, 90:5:5, 50:25:25 and 0:50:50 (operation mixFind90, mixFind50, mixFind0)
+ *	the size stays about n, so the rows compare the cost of the balancing against the one of the searches
+ */
+template <typename Tree>
+void bench::runMix(const std::string& container)
+{
+    constexpr std::size_t totalOps {1000000};
+    for (auto n : opt_.sizes) {
+        for (unsigned findPercent : {90u, 50u, 0u}) {
+            std::vector<double> samples;
+            for (int r = 0; r != opt_.repeat; ++r) {
+                Tree t;
+                for (std::size_t k = 0; k < 2 * n; k += 2)
+                    insertKey(t, static_cast<int>(k));
+                std::mt19937 gen(static_cast<std::uint32_t>(n));
+                samples.push_back(timeMs([&] {
+                    for (std::size_t i = 0; i != totalOps; ++i) {
+                        auto k {static_cast<int>(gen() % (2 * n))};
+                        auto op {gen() % 100};
+                        if (op < findPercent)
+                            sink += findKey(t, k);
+                        else if ((op - findPercent) % 2 == 0)
+                            insertKey(t, k);
+                        else
+                            eraseKey(t, k);
+                    }
+                }));
+                sink += countOf(t);
+            }
+            add(container, "mixFind" + std::to_string(findPercent), "random", n, samples, totalOps);
+        }
+    }
+}
+
+/*
+ *	finds of a uniform and of a Zipf(0.99) trace of 1,000,000 keys in a tree of the n keys [0, n) inserted in random order
+ *	(operation findTrace, pattern uniform or zipf), the trees that adapt to the accesses are timed with their changes
+ */
+template <typename Tree>
+void bench::runTrace(const std::string& container)
+{
+    constexpr std::size_t totalOps {1000000};
+    for (const std::string pattern : {"uniform", "zipf"}) {
+        for (auto n : opt_.sizes) {
+            auto keys {makeKeys("random", n, static_cast<std::uint32_t>(n))};
+            auto trace {makeTrace(pattern, n, totalOps, static_cast<std::uint32_t>(n) + 1)};
+            std::vector<double> samples;
+            for (int r = 0; r != opt_.repeat; ++r) {
+                Tree t;
+                for (auto k : keys)
+                    insertKey(t, k);
+                samples.push_back(timeMs([&] {
+                    for (auto k : trace)
+                        sink += findKey(t, k);
+                }));
+            }
+            add(container, "findTrace", pattern, n, samples, totalOps);
+        }
+    }
+}
+
+/*
+ *	std::string keys of 48 characters (beyond the small string buffer, so every copy allocates), pattern string48:
+ *	insertCopy inserts lvalues, insertMove rvalues, emplace builds each key from its characters,
+ *	find looks up std::string probes and findView std::string_view ones (heterogeneous, no key is built), then erase
+ *	std::set runs with std::less<>, its transparent comparator
+ */
+template <typename Tree>
+void bench::runStrings(const std::string& container)
+{
+    constexpr bool isSet {!requires (Tree& t) {t.root();}};
+    for (auto n : opt_.sizes) {
+        std::vector<std::string> keys;
+        keys.reserve(n);
+        for (auto k : makeKeys("random", n, static_cast<std::uint32_t>(n)))
+            keys.push_back(std::string(40, 'k') + std::to_string(10000000 + k));
+        std::vector<std::string_view> views(keys.begin(), keys.end());
+        std::vector<double> samples[6];
+        std::uint64_t allocs[6] {};
+        auto timed = [&](int i, auto&& f)
+        {
+            auto before {allocations};
+            auto ms {timeMs(f)};
+            allocs[i] = allocations - before;
+            samples[i].push_back(ms);
+        };
+        for (int r = 0; r != opt_.repeat; ++r) {
+            for (int way = 0; way != 3; ++way) {
+                Tree t;
+                auto moved {keys}; //copied before the clock starts
+                timed(way, [&] {
+                    for (std::size_t i = 0; i != n; ++i) {
+                        if constexpr (isSet) {
+                            if (way == 0)
+                                t.insert(keys[i]);
+                            else if (way == 1)
+                                t.insert(std::move(moved[i]));
+                            else
+                                t.emplace(views[i].data(), views[i].size());
+                        } else {
+                            if (way == 0)
+                                t.insert(keys[i], t.root());
+                            else if (way == 1)
+                                t.insert(std::move(moved[i]), t.root());
+                            else
+                                t.emplace(t.root(), views[i].data(), views[i].size());
+                        }
+                    }
+                });
+                if (way != 2)
+                    continue;
+                auto found = [&t](const auto& k)
+                {
+                    if constexpr (isSet)
+                        return t.contains(k);
+                    else
+                        return t.find(k);
+                };
+                timed(3, [&] {
+                    for (const auto& k : keys)
+                        sink += found(k);
+                });
+                timed(4, [&] {
+                    for (auto k : views)
+                        sink += found(k);
+                });
+                timed(5, [&] {
+                    for (const auto& k : keys) {
+                        if constexpr (isSet)
+                            t.erase(k);
+                        else
+                            t.erase(k, t.root());
+                    }
+                });
+            }
+        }
+        const char* names[] {"insertCopy", "insertMove", "emplace", "find", "findView", "erase"};
+        for (int i = 0; i != 6; ++i)
+            add(container, names[i], "string48", n, samples[i], n, allocs[i]);
+    }
+}
+
+/*
+ *	startup of a tree of the n keys [0, n) inserted in random order, from a file in the temporary directory:
+ *	loadText reads one key per line through operator>> (one parse and one insert each),
+ *	loadSnapshot maps the binary snapshot (treeSnapshot.hpp) and rebuilds it in O(n), saveSnapshot writes it
+ *	withShape saves the shape too, so the tree comes back node for node (timed on linkedBinaryTree, the others rebuild balanced)
+ *	--sizes 10000000 gives the startup of 10^7 keys
+ */
+template <typename Tree>
+void bench::runSnapshot(const std::string& container, bool withShape)
+{
+    auto dir {std::filesystem::temp_directory_path()};
+    auto textPath {(dir / "treeBench.keys").string()};
+    auto snapshotPath {(dir / "treeBench.snap").string()};
+    for (auto n : opt_.sizes) {
+        Tree source;
+        {
+            std::ofstream text(textPath);
+            for (auto k : makeKeys("random", n, static_cast<std::uint32_t>(n))) {
+                insertKey(source, k);
+                text << k << '\n';
+            }
+        }
+        std::vector<double> samples[3];
+        for (int r = 0; r != opt_.repeat; ++r) {
+            samples[2].push_back(timeMs([&] {sink += source.saveSnapshot(snapshotPath, withShape);}));
+            {
+                Tree t;
+                samples[0].push_back(timeMs([&] {
+                    std::ifstream is(textPath);
+                    while (is >> t) { }
+                }));
+                sink += countOf(t);
+            }
+            Tree t;
+            samples[1].push_back(timeMs([&] {sink += t.loadSnapshot(snapshotPath);}));
+            sink += countOf(t);
+        }
+        add(container, "loadText", "random", n, samples[0], n);
+        add(container, "loadSnapshot", "random", n, samples[1], n);
+        add(container, "saveSnapshot", "random", n, samples[2], n);
+    }
+    std::filesystem::remove(textPath);
+    std::filesystem::remove(snapshotPath);
+}
+
+/*
+ *	1, 2, 4, ... --threads threads share one tree prefilled with every other key of [0, 2n),
+ *	each runs its part of a fixed number of random operations: 80% find, 10% insert, 10% erase
+ */
+template <typename Tree>
+void bench::runScaling(const std::string& container)
+{
+    constexpr std::size_t totalOps {1000000};
+    for (auto n : opt_.sizes) {
+        for (unsigned t = 1; ; t = std::min(t * 2, opt_.threads)) {
+            std::vector<double> samples;
+            for (int r = 0; r != opt_.repeat; ++r) {
+                Tree tree;
+                for (std::size_t k = 0; k < 2 * n; k += 2)
+                    tree.insert(static_cast<int>(k));
+                std::vector<std::thread> workers;
+                samples.push_back(timeMs([&] {
+                    for (unsigned id = 0; id != t; ++id)
+                        workers.emplace_back([&tree, id, n, t] {
+                            std::mt19937 gen(id + 1);
+                            std::uint64_t hits {};
+                            for (std::size_t i = 0; i != totalOps / t; ++i) {
+                                auto k {static_cast<int>(gen() % (2 * n))};
+                                auto op {gen() % 10};
+                                hits += op == 0 ? tree.insert(k) : op == 1 ? tree.erase(k) : tree.find(k);
+                            }
+                            std::atomic_ref<std::uint64_t>(sink) += hits;
+                        });
+                    for (auto& w : workers)
+                        w.join();
+                }));
+            }
+            threads = t;
+            add(container, "mixed", "random", n, samples, totalOps / t * t);
+            if (t == opt_.threads)
+                break;
+        }
+    }
+    threads = 1;
+}
+
+/*
+ *	1, 2, 4, ... --threads threads only find, while one more thread inserts and erases random keys
+ *	until they are done, the tree is prefilled like in runScaling, the time is the one of the readers
+ */
+template <typename Tree>
+void bench::runReaders(const std::string& container)
+{
+    constexpr std::size_t totalOps {1000000};
+    for (auto n : opt_.sizes) {
+        for (unsigned t = 1; ; t = std::min(t * 2, opt_.threads)) {
+            std::vector<double> samples;
+            for (int r = 0; r != opt_.repeat; ++r) {
+                Tree tree;
+                for (std::size_t k = 0; k < 2 * n; k += 2)
+                    tree.insert(static_cast<int>(k));
+                std::atomic<bool> done {false};
+                std::thread writer([&tree, &done, n] {
+                    std::mt19937 gen(0);
+                    while (!done.load(std::memory_order_relaxed)) {
+                        auto k {static_cast<int>(gen() % (2 * n))};
+                        std::atomic_ref<std::uint64_t>(sink) += gen() % 2 == 0 ? tree.insert(k) : tree.erase(k);
+                    }
+                });
+                std::vector<std::thread> readers;
+                samples.push_back(timeMs([&] {
+                    for (unsigned id = 0; id != t; ++id)
+                        readers.emplace_back([&tree, id, n, t] {
+                            std::mt19937 gen(id + 1);
+                            std::uint64_t hits {};
+                            for (std::size_t i = 0; i != totalOps / t; ++i)
+                                hits += tree.find(static_cast<int>(gen() % (2 * n)));
+                            std::atomic_ref<std::uint64_t>(sink) += hits;
+                        });
+                    for (auto& reader : readers)
+                        reader.join();
+                }));
+                done = true;
+                writer.join();
+            }
+            threads = t;
+            add(container, "readWhileWriting", "random", n, samples, totalOps / t * t);
+            if (t == opt_.threads)
+                break;
+        }
+    }
+    threads = 1;
+}
+
+/*
+ *	every thread inserts, erases and finds keys of its own residue class modulo the thread count
+ *	and checks every answer against its own record, while also searching the keys of the others
+ *	at the end the tree must hold exactly the recorded keys, in order, and be empty once they are erased
+ */
+bool stressConcurrent(unsigned threads, int opsPerThread)
+{
+    constexpr int range {4096};
+    concurrentAvlTree<int> tree;
+    std::vector<std::vector<char>> expected(threads, std::vector<char>(range));
+    std::atomic<bool> failed {false};
+    std::vector<std::thread> workers;
+    for (unsigned id = 0; id != threads; ++id)
+        workers.emplace_back([&, id] {
+            std::mt19937 gen(id + 1);
+            auto& mine {expected[id]};
+            std::uint64_t hits {};
+            for (int i = 0; i != opsPerThread && !failed; ++i) {
+                auto k {static_cast<int>(gen() % (range / threads) * threads + id)};
+                switch (gen() % 4) {
+                case 0:
+                    failed = failed || tree.insert(k) == (mine[k] != 0);
+                    mine[k] = 1;
+                    break;
+                case 1:
+                    failed = failed || tree.erase(k) != (mine[k] != 0);
+                    mine[k] = 0;
+                    break;
+                case 2:
+                    failed = failed || tree.find(k) != (mine[k] != 0);
+                    break;
+                default:
+                    hits += tree.find(static_cast<int>(gen() % range));
+                }
+            }
+            std::atomic_ref<std::uint64_t>(sink) += hits;
+        });
+    for (auto& w : workers)
+        w.join();
+    std::vector<int> keys;
+    for (int k = 0; k != range; ++k)
+        if (expected[k % threads][k] != 0)
+            keys.push_back(k);
+    std::vector<int> contents;
+    tree.inOrder([&contents](int k) {contents.push_back(k);});
+    bool ok {!failed && contents == keys && tree.empty() == keys.empty()};
+    for (auto k : keys)
+        ok = tree.erase(k) && ok;
+    return ok && tree.empty();
+}
+
+/*
+ *	the balanced builds that go through linkedBinaryTree (seqBinaryTree::toTree, loadSnapshot through the base)
+ *	must hand back a valid redBlackTree, for every size up to maxSize, and updates must keep it valid
+ */
+bool checkRedBlack(std::size_t maxSize)
+{
+    auto path {(std::filesystem::temp_directory_path() / "treeBench.rb.snap").string()};
+    bool ok {true};
+    for (std::size_t n = 1; n <= maxSize && ok; ++n) {
+        avlTree<int> source;
+        auto keys {makeKeys("sequential", n, 0)};
+        source.build(keys.begin(), keys.end());
+        redBlackTree<int> t;
+        seqBinaryTree<int>(source).toTree(t);
+        ok = t.valid() && t.nodeCount() == static_cast<int>(n);
+        source.saveSnapshot(path, true);
+        redBlackTree<int> loaded;
+        ok = ok && static_cast<linkedBinaryTree<int>&>(loaded).loadSnapshot(path, true) && loaded.valid();
+        std::mt19937 gen(static_cast<std::uint32_t>(n));
+        for (std::size_t i = 0; i != 2 * n && ok; ++i) {
+            auto k {static_cast<int>(gen() % (2 * n))};
+            if (gen() % 2 == 0)
+                t.insert(k, t.root());
+            else
+                t.erase(k, t.root());
+            ok = t.valid();
+        }
+    }
+    std::filesystem::remove(path);
+    return ok;
+}
+
+/*
+ *	the plain tree may be a chain as deep as it holds keys: a chain of depth keys is loaded from a snapshot written
+ *	by hand (its shape gives every node a right child only, inserting them through root() would take O(n^2)),
+ *	then every walk, the copy, freeze, levelInfo and erase through root() must get through it without recursing
+ *	and an insert or erase through the link of a subtree must keep the heights above that subtree right
+ */
+bool checkDeepChain(int depth)
+{
+    linkedBinaryTree<int> small;
+    small.insert(5, small.root());
+    small.insert(8, small.root());
+    small.insert(9, small.root()->rightChild_);
+    small.insert(10, small.root()->rightChild_);
+    bool ok {small.height() == 4 && small.levelInfo() == std::vector<int>{1, 1, 1, 1}};
+    small.erase(9, small.root()->rightChild_);
+    ok = ok && small.height() == 3 && small.levelInfo() == std::vector<int>{1, 1, 1};
+
+    auto path {(std::filesystem::temp_directory_path() / "treeBench.chain.snap").string()};
+    snapshotWriter w(path);
+    for (int k = 0; k != depth; ++k)
+        w.write(&k, sizeof(k));
+    for (int k = 0; k < depth; k += 4) {
+        unsigned char shape {};
+        for (int i = 0; i != 4 && k + i + 1 < depth; ++i)
+            shape |= static_cast<unsigned char>(2 << 2 * i); //bit 1: a right child
+        w.write(&shape, 1);
+    }
+    snapshotHeader header {{'T', 'R', 'E', 'E', 'S', 'N', 'A', 'P'}, snapshotHeader::currentVersion, sizeof(int),
+                           static_cast<std::uint64_t>(depth), snapshotHeader::shape, 0};
+    ok = ok && w.close(header);
+    linkedBinaryTree<int> chain;
+    ok = ok && chain.loadSnapshot(path, true) && chain.height() == depth;
+    std::filesystem::remove(path);
+    int visited {};
+    auto count {[&visited](const auto&) {++visited;}};
+    chain.preOrder(count);
+    chain.inOrder(count);
+    chain.postOrder(count);
+    chain.levelOrder(count);
+    ok = ok && visited == 4 * depth && chain.width() == 1 && chain.levelInfo().size() == static_cast<std::size_t>(depth);
+    linkedBinaryTree<int> copy(chain);
+    ok = ok && copy.height() == depth && copy.freeze().contains(depth - 1);
+    chain.insert(depth, chain.root());
+    ok = ok && chain.erase(0, chain.root()) && chain.erase(depth / 2, chain.root()) && chain.erase(depth, chain.root())
+         && chain.height() == depth - 2 && chain.nodeCount() == depth - 2;
+    return ok;
+}
+
+/*
+ *	the batch lookup of frozenTree (eight keys at a time through AVX2 when the build targets it)
+ *	must answer like the single one, for every size up to maxSize, signed and unsigned keys, hits and misses
+ */
+template <typename Key>
+bool checkFrozenBatch(std::size_t maxSize)
+{
+    std::mt19937 gen(1);
+    std::vector<Key> elements, probes;
+    std::vector<char> expected;
+    for (std::size_t n = 0; n <= maxSize; ++n) {
+        elements.clear();
+        for (std::size_t i = 0; i != n; ++i) //every other value of a range around 0, so misses fall between them
+            elements.push_back(static_cast<Key>(2 * i - n));
+        std::sort(elements.begin(), elements.end()); //the negative ones wrap around for unsigned keys
+        frozenTree<Key> frozen(elements.begin(), elements.end());
+        probes.resize(2 * n + 11); //not a multiple of eight: the rest goes through the single lookup
+        for (auto& k : probes)
+            k = static_cast<Key>(gen() % (2 * n + 4) - n - 2);
+        probes[0] = std::numeric_limits<Key>::min();
+        probes[1] = std::numeric_limits<Key>::max();
+        auto found {std::make_unique<bool[]>(probes.size())};
+        frozen.contains(probes.data(), probes.size(), found.get());
+        for (std::size_t i = 0; i != probes.size(); ++i)
+            if (found[i] != frozen.contains(probes[i]))
+                return false;
+    }
+    return true;
+}
+
+void writeJson(std::ostream& os, const std::vector<result>& results)
+{
+    os << "{\n  \"benchmark\": \"treeBench\",\n  \"results\": [\n";
+    for (std::size_t i = 0; i != results.size(); ++i) {
+        const auto& r {results[i]};
+        os << "    {\"container\": \"" << r.container << "\", \"operation\": \"" << r.operation
+           << "\", \"pattern\": \"" << r.pattern << "\", \"size\": " << r.size
+           << ", \"threads\": " << r.threads << ", \"batch\": " << r.batch << ", \"nsPerOp\": " << r.nsPerOp << ", \"totalMs\": " << r.totalMs;
+        if (r.allocsPerOp >= 0)
+            os << ", \"allocsPerOp\": " << r.allocsPerOp;
+        os << '}' << (i + 1 == results.size() ? "\n" : ",\n");
+    }
+    os << "  ]\n}\n";
+}
+
+void writeCsv(std::ostream& os, const std::vector<result>& results)
+{
+    os << "container,operation,pattern,size,threads,batch,nsPerOp,totalMs,allocsPerOp\n";
+    for (const auto& r : results) {
+        os << r.container << ',' << r.operation << ',' << r.pattern << ',' << r.size << ',' << r.threads << ',' << r.batch << ','
+           << r.nsPerOp << ',' << r.totalMs << ',';
+        if (r.allocsPerOp >= 0)
+            os << r.allocsPerOp;
+        os << '\n';
+    }
+}
+
+bool parse(int argc, char* argv[], options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg {argv[i]};
+        if (i + 1 == argc)
+            return false;
+        std::string value {argv[++i]};
+        if (arg == "--format" && (value == "json" || value == "csv"))
+            opt.format = value;
+        else if (arg == "--repeat" && std::atoi(value.c_str()) > 0)
+            opt.repeat = std::atoi(value.c_str());
+        else if (arg == "--threads" && std::atoi(value.c_str()) > 0)
+            opt.threads = static_cast<unsigned>(std::atoi(value.c_str()));
+        else if (arg == "--stress" && std::atoi(value.c_str()) > 0)
+            opt.stress = std::atoi(value.c_str());
+        else if (arg == "--out")
+            opt.out = value;
+        else if (arg == "--sizes") {
+            opt.sizes.clear();
+            std::istringstream is(value);
+            for (std::string s; std::getline(is, s, ','); )
+                if (std::atoll(s.c_str()) > 0)
+                    opt.sizes.push_back(static_cast<std::size_t>(std::atoll(s.c_str())));
+            if (opt.sizes.empty())
+                return false;
+        } else
+            return false;
+    }
+    return true;
+}
+
+} //namespace
+
+int main(int argc, char* argv[])
+{
+    options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "usage: treeBench [--format json|csv] [--sizes 1000,10000,...] [--repeat N] [--threads N] [--out file]\n"
+                     "       treeBench --stress N [--threads N]\n";
+        return 2;
+    }
+    if (opt.stress != 0) {
+        auto ok {stressConcurrent(std::max(opt.threads, 2u), opt.stress) && checkRedBlack(1024) && checkDeepChain(100000)
+                   && checkFrozenBatch<int>(1024) && checkFrozenBatch<unsigned>(1024)};
+        std::cout << "stress " << (ok ? "ok" : "FAILED") << '\n';
+        return ok ? 0 : 1;
+    }
+    bench b(opt);
+    b.run<linkedBinaryTree<int>>("linkedBinaryTree", 10000);
+    b.run<avlTree<int>>("avlTree");
+    b.run<avlTree<int, poolAllocator<>>>("avlTree<poolAllocator>");
+    b.run<redBlackTree<int>>("redBlackTree");
+    b.run<bPlusTree<int>>("bPlusTree");
+    b.run<std::set<int>>("std::set");
+    b.runSeq();
+    b.runBatch();
+    b.runMix<avlTree<int>>("avlTree");
+    b.runMix<redBlackTree<int>>("redBlackTree");
+    b.runMix<std::set<int>>("std::set");
+    b.runTrace<avlTree<int>>("avlTree");
+    b.runTrace<splayTree<int>>("splayTree");
+    b.runTrace<readMostlySplayTree<int>>("readMostlySplayTree");
+    b.runTrace<std::set<int>>("std::set");
+    b.runStrings<avlTree<std::string>>("avlTree");
+    b.runStrings<redBlackTree<std::string>>("redBlackTree");
+    b.runStrings<std::set<std::string, std::less<>>>("std::set");
+    b.runSnapshot<avlTree<int>>("avlTree", false);
+    b.runSnapshot<avlTree<int, poolAllocator<>>>("avlTree<poolAllocator>", false);
+    b.runSnapshot<linkedBinaryTree<int>>("linkedBinaryTree", true);
+    b.runScaling<concurrentAvlTree<int>>("concurrentAvlTree");
+    b.runScaling<lockedAvlTree>("avlTree+mutex");
+    b.runScaling<rcuAvlTree<int>>("rcuAvlTree");
+    b.runReaders<rcuAvlTree<int>>("rcuAvlTree");
+    b.runReaders<concurrentAvlTree<int>>("concurrentAvlTree");
+    b.runReaders<lockedAvlTree>("avlTree+mutex");
+    std::ofstream file;
+    if (!opt.out.empty()) {
+        file.open(opt.out);
+        if (!file) {
+            std::cerr << "treeBench: cannot write " << opt.out << '\n';
+            return 1;
+        }
+    }
+    auto& os {opt.out.empty() ? std::cout : static_cast<std::ostream&>(file)};
+    if (opt.format == "csv")
+        writeCsv(os, b.results());
+    else
+        writeJson(os, b.results());
+    return 0;
+}
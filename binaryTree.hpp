@@ -1,6 +1,10 @@
 #ifndef BINARYTREE_H
 #define BINARYTREE_H
 
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
 template <typename T>
 class binaryTree
 {
@@ -11,4 +15,33 @@ public:
     virtual int nodeCount() noexcept = 0;
 };
 
+/*
+ *	heterogeneous lookup: a key K that is compared with the elements T as it is, by < and ==, so no T is built for it
+ *	(std::string elements found by std::string_view or const char*), what a transparent comparator is to std::set
+ *	arithmetic keys are left to the conversion to T, so find(2.5) in a tree of int still looks for 2
+ */
+template <typename K, typename T>
+concept transparentKey = !std::is_arithmetic_v<K> && !std::same_as<K, T> && requires (const K& k, const T& t) {
+    {k < t} -> std::convertible_to<bool>;
+    {t < k} -> std::convertible_to<bool>;
+    {t == k} -> std::convertible_to<bool>;
+};
+
+/*
+ *	visitor protocol of the traversals
+ *	a visitor is called with a node (const node& through a const tree) and,
+ *	for a level-order walk, optionally the level No. and the position in the level as well
+ *	it returns void to see every node, or bool: false stops the walk there
+ *	the traversals return false if they were stopped, true if they saw every node
+ */
+template <typename Visit, typename... Args>
+inline bool visitNode(Visit& theVisit, Args&&... args)
+{
+    if constexpr (std::is_void_v<std::invoke_result_t<Visit&, Args...>>) {
+        theVisit(std::forward<Args>(args)...);
+        return true;
+    } else
+        return static_cast<bool>(theVisit(std::forward<Args>(args)...));
+}
+
 #endif // BINARYTREE_H
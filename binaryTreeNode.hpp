@@ -2,35 +2,25 @@
 #define BINARYTREENODE_H
 
 #include <memory>
+#include <utility>
+#include "nodeAllocator.hpp"
+#include "nodeAugment.hpp"
 
-template <typename T>
-class binaryTreeNode
+//the augmentation policy adds its fields (subtree size, summaries) through the base class
+template <typename T, typename Alloc = heapAllocator, typename Augment = noAugment>
+class binaryTreeNode : public Augment::template data<T>
 {
-    using nodePtr = std::unique_ptr<binaryTreeNode<T>>;
 public:
+    using nodePtr = std::unique_ptr<binaryTreeNode, typename Alloc::template deleter<binaryTreeNode>>;
     T element_;
     nodePtr leftChild_;
     nodePtr rightChild_;
+    binaryTreeNode* parent_ {nullptr}; //non-owning, nullptr for the root
+    int height_ {1}; //cached height of the subtree rooted here (a leaf is 1)
+    bool red_ {}; //the color for redBlackTree, it takes the padding after height_, so no tree pays for it
     binaryTreeNode() : element_(), leftChild_(), rightChild_() { }
     binaryTreeNode(const T& theElement) : element_(theElement), leftChild_(), rightChild_() { }
-    binaryTreeNode(const nodePtr&);
-};
-
-template <typename T>
-binaryTreeNode<T>::binaryTreeNode(const nodePtr& rhs)
-{
-    //deep copy
-    if (rhs == nullptr)
-        binaryTreeNode();
-    else {
-        element_ = rhs->element_;
-        if (rhs->leftChild_ != nullptr) {
-            leftChild_ = std::make_unique<binaryTreeNode<T>>(rhs->leftChild_);
-        }
-        if (rhs->rightChild_ != nullptr) {
-            rightChild_ = std::make_unique<binaryTreeNode<T>>(rhs->rightChild_);
-        }
-    }
+    binaryTreeNode(T&& theElement) : element_(std::move(theElement)), leftChild_(), rightChild_() { }
 };
 
 #endif // BINARYTREENODE_H
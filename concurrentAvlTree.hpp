@@ -0,0 +1,567 @@
+#ifndef CONCURRENTAVLTREE_HPP
+#define CONCURRENTAVLTREE_HPP
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "binaryTree.hpp"
+#include "epochReclaimer.hpp"
+
+template <typename T>
+class concurrentNode;
+
+/*
+ *	the part of a node the concurrent tree locks and validates
+ *	the tree's root holder is one of these without an element, its right child is the root
+ */
+template <typename T>
+class concurrentLinks
+{
+public:
+    using node = concurrentNode<T>;
+    /*
+     *	version_: bit 0 unlinked (final), bit 1 changing (a rotation is moving the node down), the rest counts changes
+     *	a reader that went through a node before a change of it has to go back
+     */
+    std::atomic<std::uint64_t> version_ {0};
+    std::atomic<int> height_ {0};
+    std::atomic<concurrentLinks*> parent_ {nullptr};
+    std::atomic<node*> leftChild_ {nullptr};
+    std::atomic<node*> rightChild_ {nullptr};
+    //a spin lock: it is held for a few stores, a mutex would make the node three times as large
+    void lock() noexcept
+    {
+        while (locked_.exchange(true, std::memory_order_acquire))
+            while (locked_.load(std::memory_order_relaxed))
+                std::this_thread::yield();
+    }
+    void unlock() noexcept {locked_.store(false, std::memory_order_release);}
+    std::atomic<node*>& child(bool right) noexcept {return right ? rightChild_ : leftChild_;}
+private:
+    std::atomic<bool> locked_ {false};
+};
+
+template <typename T>
+class concurrentNode : public concurrentLinks<T>
+{
+public:
+    const T element_;
+    std::atomic<bool> present_ {true}; //false: a routing node kept for its two children, or unlinked
+    concurrentNode(const T& theElement, concurrentLinks<T>* parent) : element_(theElement)
+    {
+        this->height_.store(1, std::memory_order_relaxed);
+        this->parent_.store(parent, std::memory_order_relaxed);
+    }
+};
+
+/*
+ *	AVL tree for insert, erase and find from many threads at once
+ *	the algorithm of Bronson, Casper, Chafi and Olukotun, "A Practical Concurrent Binary Search Tree" (PPoPP 2010):
+ *	  find takes no lock: it validates the version of each node after reading the link out of it (hand over hand),
+ *	  and starts again from the root when the node changed meanwhile (the paper goes back one level,
+ *	  which needs a recursive descent, rotations near the root are too rare to pay for that)
+ *	  insert locks the node it links the new leaf to, erase locks the parent and the node it unlinks,
+ *	  a node with two children is only marked absent (a routing node) and unlinked later
+ *	  the balance is relaxed: after a change the heights are repaired and the rotations done bottom up,
+ *	  locking a parent, the node and the children involved, always from the top down
+ *	unlinked nodes go to epochReclaimer, since a reader may still be standing on one
+ *	empty, nodeCount, height and inOrder see a consistent tree only while no thread changes it
+ */
+template <typename T>
+class concurrentAvlTree : public binaryTree<concurrentNode<T>>
+{
+    using node = concurrentNode<T>;
+    using links = concurrentLinks<T>;
+
+public:
+    concurrentAvlTree() = default;
+    concurrentAvlTree(const concurrentAvlTree&) = delete;
+    concurrentAvlTree& operator=(const concurrentAvlTree&) = delete;
+    ~concurrentAvlTree();
+    /*
+     *	a node with less than two children is present (an absent one is unlinked as soon as it loses one),
+     *	so the leftmost path meets a present node below the routing nodes at its top, mostly the root itself
+     */
+    inline bool empty() const override
+    {
+        epochReclaimer::guard pin;
+        for (auto t = child_(&holder_, true); t != nullptr; t = child_(t, false))
+            if (t->present_.load())
+                return false;
+        return true;
+    }
+    inline int height() noexcept override
+    {
+        auto root {holder_.rightChild_.load(std::memory_order_acquire)};
+        return root == nullptr ? 0 : root->height_.load(std::memory_order_relaxed);
+    }
+    int nodeCount() noexcept override;
+    bool find(const T&) const;
+    bool insert(const T&); //false if it was there already
+    bool erase(const T&); //false if it was not there
+    //the visitor sees const T& in order, see visitNode for the protocol
+    template <typename Visit>
+    bool inOrder(Visit&&) const;
+private:
+    mutable links holder_;
+    enum result_ {no_, yes_, retry_}; //the answer of find, whether insert or erase changed the tree, or go back
+    static constexpr std::uint64_t unlinked_ {1};
+    static constexpr std::uint64_t changing_ {2};
+    static constexpr std::uint64_t change_ {4};
+    //what a node needs (nodeCondition_ returns the height it should have otherwise)
+    static constexpr int nothing_ {-1};
+    static constexpr int unlink_ {-2};
+    static constexpr int rebalance_ {-3};
+    /*
+     *	unlink_nl_ runs under spin locks, so it only notes the node in pending_, and the nodes go to epochReclaimer
+     *	(whose retire may allocate) by retirePending_ once the locks are released
+     *	one locked step unlinks three nodes at most (a double rotation: n, c and inner)
+     */
+    struct pendingNodes_
+    {
+        std::array<node*, 3> nodes_ {};
+        std::size_t count_ {};
+    };
+    static pendingNodes_& pending_() noexcept
+    {
+        thread_local pendingNodes_ nodes;
+        return nodes;
+    }
+    static void retirePending_();
+    static int height_(const node* t) noexcept {return t == nullptr ? 0 : t->height_.load(std::memory_order_relaxed);}
+    static std::uint64_t version_(const links* t) noexcept {return t->version_.load();}
+    static node* child_(links* t, bool right) noexcept {return t->child(right).load(std::memory_order_acquire);}
+    static void waitUntilNotChanging_(const links* t) noexcept
+    {
+        for (int spins = 0; (version_(t) & changing_) != 0; ++spins)
+            if (spins > 64)
+                std::this_thread::yield();
+    }
+    node* asNode_(links* t) const noexcept {return t == &holder_ ? nullptr : static_cast<node*>(t);}
+    node* locate_(const T&, links*&, bool&, std::uint64_t&) const;
+    result_ update_(const T&, bool);
+    result_ attach_(const T&, links*, bool, std::uint64_t);
+    result_ updateNode_(bool, links*, node*);
+    //_nl: the caller holds the lock of the node (and of the parent where there is one)
+    static bool unlink_nl_(links*, node*);
+    static int nodeCondition_(node*) noexcept;
+    static links* fixHeight_nl_(node*) noexcept;
+    void fixHeightAndRebalance_(links*);
+    links* rebalance_nl_(links*, node*);
+    links* rebalanceTo_nl_(links*, node*, node*, int, bool);
+    links* rotate_nl_(links*, node*, node*, int, int, node*, int, bool);
+    links* rotateOver_nl_(links*, node*, node*, int, int, node*, int, bool);
+};
+
+template <typename T>
+concurrentAvlTree<T>::~concurrentAvlTree()
+{
+    //no other thread may use the tree now, and the unlinked nodes belong to the reclaimer
+    std::vector<node*> stack;
+    if (auto root {holder_.rightChild_.load()}; root != nullptr)
+        stack.push_back(root);
+    while (!stack.empty()) {
+        auto t {stack.back()};
+        stack.pop_back();
+        if (auto l {t->leftChild_.load()}; l != nullptr)
+            stack.push_back(l);
+        if (auto r {t->rightChild_.load()}; r != nullptr)
+            stack.push_back(r);
+        delete t;
+    }
+}
+
+template <typename T>
+bool concurrentAvlTree<T>::find(const T& theElement) const
+{
+    epochReclaimer::guard pin;
+    links* t;
+    bool right;
+    std::uint64_t nodeVersion;
+    auto n {locate_(theElement, t, right, nodeVersion)};
+    return n != nullptr && n->present_.load();
+}
+
+template <typename T>
+bool concurrentAvlTree<T>::insert(const T& theElement)
+{
+    epochReclaimer::guard pin;
+    return update_(theElement, true) == yes_;
+}
+
+template <typename T>
+bool concurrentAvlTree<T>::erase(const T& theElement)
+{
+    epochReclaimer::guard pin;
+    return update_(theElement, false) == yes_;
+}
+
+template <typename T>
+int concurrentAvlTree<T>::nodeCount() noexcept
+{
+    int count {};
+    inOrder([&count](const T&) {++count;});
+    return count;
+}
+
+template <typename T>
+template <typename Visit>
+bool concurrentAvlTree<T>::inOrder(Visit&& theVisit) const
+{
+    epochReclaimer::guard pin;
+    std::vector<node*> stack;
+    for (auto t = child_(&holder_, true); t != nullptr || !stack.empty(); ) {
+        for (; t != nullptr; t = child_(t, false))
+            stack.push_back(t);
+        t = stack.back();
+        stack.pop_back();
+        if (t->present_.load() && !visitNode(theVisit, t->element_))
+            return false;
+        t = child_(t, true);
+    }
+    return true;
+}
+
+/*
+ *	the node holding the key, or nullptr if there is none
+ *	t, right and nodeVersion tell where it hangs (or would hang): the side right of t, whose version was nodeVersion
+ */
+template <typename T>
+typename concurrentAvlTree<T>::node* concurrentAvlTree<T>::locate_(const T& theElement, links*& t, bool& right, std::uint64_t& nodeVersion) const
+{
+    for (;;) { //from the root
+        t = &holder_;
+        right = true;
+        nodeVersion = version_(t);
+        for (;;) {
+            auto child {child_(t, right)};
+            if (version_(t) != nodeVersion)
+                break; //t has moved, the key may not be below it any more
+            if (child == nullptr)
+                return nullptr;
+            auto less {theElement < child->element_};
+            auto greater {child->element_ < theElement};
+            if (!less && !greater)
+                return child;
+            auto childVersion {version_(child)};
+            if ((childVersion & (changing_ | unlinked_)) != 0) {
+                waitUntilNotChanging_(child); //unlinked: the link of t has changed, read it again
+                continue;
+            }
+            if (child != child_(t, right) || version_(t) != nodeVersion)
+                continue; //the top of the loop tells which
+            t = child;
+            right = greater;
+            nodeVersion = childVersion;
+        }
+    }
+}
+
+//link a new leaf (insert) or take the element out of its node (erase), start again whenever a check fails
+template <typename T>
+typename concurrentAvlTree<T>::result_ concurrentAvlTree<T>::update_(const T& theElement, bool insert)
+{
+    for (;;) {
+        links* t;
+        bool right;
+        std::uint64_t nodeVersion;
+        auto n {locate_(theElement, t, right, nodeVersion)};
+        result_ r;
+        if (n != nullptr)
+            r = updateNode_(insert, t, n);
+        else if (insert)
+            r = attach_(theElement, t, right, nodeVersion);
+        else
+            return no_;
+        if (r != retry_)
+            return r;
+    }
+}
+
+template <typename T>
+typename concurrentAvlTree<T>::result_ concurrentAvlTree<T>::attach_(const T& theElement, links* t, bool right, std::uint64_t nodeVersion)
+{
+    links* damaged {nullptr};
+    {
+        std::lock_guard<links> lock(*t);
+        if (version_(t) != nodeVersion || child_(t, right) != nullptr)
+            return retry_; //moved, or another thread linked one here first
+        auto leaf {new node(theElement, t)};
+        t->child(right).store(leaf, std::memory_order_release);
+        if (auto n {asNode_(t)}; n != nullptr)
+            damaged = fixHeight_nl_(n);
+    }
+    fixHeightAndRebalance_(damaged);
+    return yes_;
+}
+
+/*
+ *	the element of n is the key: insert marks it present again,
+ *	erase unlinks a node with at most one child (locking parent, then n) and marks any other one absent
+ */
+template <typename T>
+typename concurrentAvlTree<T>::result_ concurrentAvlTree<T>::updateNode_(bool insert, links* parent, node* n)
+{
+    if (insert) {
+        std::lock_guard<links> lock(*n);
+        if ((version_(n) & unlinked_) != 0)
+            return retry_;
+        return n->present_.exchange(true) ? no_ : yes_;
+    }
+    if (!n->present_.load())
+        return no_;
+    for (;;) {
+        if (child_(n, false) == nullptr || child_(n, true) == nullptr) {
+            links* damaged {nullptr};
+            {
+                std::lock_guard<links> parentLock(*parent);
+                if ((version_(parent) & unlinked_) != 0 || n->parent_.load() != parent)
+                    return retry_;
+                std::lock_guard<links> lock(*n);
+                if (!n->present_.load())
+                    return no_;
+                if (!unlink_nl_(parent, n)) { //it has got a second child meanwhile
+                    n->present_.store(false);
+                    return yes_;
+                }
+                if (auto p {asNode_(parent)}; p != nullptr)
+                    damaged = fixHeight_nl_(p);
+            }
+            retirePending_();
+            fixHeightAndRebalance_(damaged);
+            return yes_;
+        }
+        std::lock_guard<links> lock(*n);
+        if ((version_(n) & unlinked_) != 0)
+            return retry_;
+        if (child_(n, false) == nullptr || child_(n, true) == nullptr)
+            continue; //lost a child meanwhile, unlink it instead
+        return n->present_.exchange(false) ? yes_ : no_;
+    }
+}
+
+//splice n (at most one child) out of parent, false if that is not possible any more
+template <typename T>
+bool concurrentAvlTree<T>::unlink_nl_(links* parent, node* n)
+{
+    auto parentLeft {child_(parent, false)};
+    if (parentLeft != n && child_(parent, true) != n)
+        return false;
+    auto left {child_(n, false)};
+    auto right {child_(n, true)};
+    if (left != nullptr && right != nullptr)
+        return false;
+    auto splice {left != nullptr ? left : right};
+    parent->child(parentLeft != n).store(splice, std::memory_order_release);
+    if (splice != nullptr)
+        splice->parent_.store(parent);
+    n->version_.store(unlinked_);
+    n->present_.store(false);
+    auto& pending {pending_()};
+    pending.nodes_[pending.count_++] = n;
+    return true;
+}
+
+template <typename T>
+void concurrentAvlTree<T>::retirePending_()
+{
+    auto& pending {pending_()};
+    for (std::size_t i = 0; i != pending.count_; ++i)
+        epochReclaimer::instance().retire(pending.nodes_[i]);
+    pending.count_ = 0;
+}
+
+template <typename T>
+int concurrentAvlTree<T>::nodeCondition_(node* n) noexcept
+{
+    auto left {child_(n, false)};
+    auto right {child_(n, true)};
+    if ((left == nullptr || right == nullptr) && !n->present_.load())
+        return unlink_;
+    auto hl {height_(left)};
+    auto hr {height_(right)};
+    if (hl - hr > 1 || hr - hl > 1)
+        return rebalance_;
+    auto h {std::max(hl, hr) + 1};
+    return h != n->height_.load(std::memory_order_relaxed) ? h : nothing_;
+}
+
+//the next node to repair: n itself if it needs more than a height, its parent after a new height, nullptr if done
+template <typename T>
+typename concurrentAvlTree<T>::links* concurrentAvlTree<T>::fixHeight_nl_(node* n) noexcept
+{
+    auto c {nodeCondition_(n)};
+    if (c == unlink_ || c == rebalance_)
+        return n;
+    if (c == nothing_)
+        return nullptr;
+    n->height_.store(c, std::memory_order_relaxed);
+    return n->parent_.load();
+}
+
+template <typename T>
+void concurrentAvlTree<T>::fixHeightAndRebalance_(links* damaged)
+{
+    for (auto n = damaged == nullptr ? nullptr : asNode_(damaged); n != nullptr; ) {
+        auto c {nodeCondition_(n)};
+        if (c == nothing_ || (version_(n) & unlinked_) != 0)
+            return;
+        links* next {n};
+        if (c != unlink_ && c != rebalance_) {
+            std::lock_guard<links> lock(*n);
+            next = fixHeight_nl_(n);
+        } else {
+            auto parent {n->parent_.load()};
+            {
+                std::lock_guard<links> parentLock(*parent);
+                if ((version_(parent) & unlinked_) == 0 && n->parent_.load() == parent) {
+                    std::lock_guard<links> lock(*n);
+                    next = rebalance_nl_(parent, n);
+                } //else n has moved, look at it again
+            }
+            retirePending_();
+        }
+        n = next == nullptr ? nullptr : asNode_(next);
+    }
+}
+
+template <typename T>
+typename concurrentAvlTree<T>::links* concurrentAvlTree<T>::rebalance_nl_(links* parent, node* n)
+{
+    auto left {child_(n, false)};
+    auto right {child_(n, true)};
+    if ((left == nullptr || right == nullptr) && !n->present_.load()) {
+        if (!unlink_nl_(parent, n))
+            return n;
+        auto p {asNode_(parent)};
+        return p == nullptr ? nullptr : fixHeight_nl_(p);
+    }
+    auto hl {height_(left)};
+    auto hr {height_(right)};
+    if (hl - hr > 1)
+        return rebalanceTo_nl_(parent, n, left, hr, false);
+    if (hr - hl > 1)
+        return rebalanceTo_nl_(parent, n, right, hl, true);
+    if (auto h {std::max(hl, hr) + 1}; h != n->height_.load(std::memory_order_relaxed)) {
+        n->height_.store(h, std::memory_order_relaxed);
+        auto p {asNode_(parent)};
+        return p == nullptr ? nullptr : fixHeight_nl_(p);
+    }
+    return nullptr;
+}
+
+/*
+ *	n leans to the side heavyRight, c is its child there and lightHeight the height of the other child
+ *	locks c (and its inner child for a double rotation), then rotates n down to the other side
+ *	names below are those of a left-heavy n (rotate right), the right-heavy case is the mirror image
+ */
+template <typename T>
+typename concurrentAvlTree<T>::links* concurrentAvlTree<T>::rebalanceTo_nl_(links* parent, node* n, node* c, int lightHeight, bool heavyRight)
+{
+    std::lock_guard<links> lock(*c);
+    if (c->height_.load(std::memory_order_relaxed) - lightHeight <= 1)
+        return n; //changed meanwhile, look at n again
+    auto inner {child_(c, !heavyRight)};
+    auto outerHeight {height_(child_(c, heavyRight))};
+    auto innerHeight {height_(inner)};
+    if (outerHeight >= innerHeight)
+        return rotate_nl_(parent, n, c, lightHeight, outerHeight, inner, innerHeight, heavyRight);
+    {
+        std::lock_guard<links> innerLock(*inner);
+        innerHeight = inner->height_.load(std::memory_order_relaxed);
+        if (outerHeight >= innerHeight)
+            return rotate_nl_(parent, n, c, lightHeight, outerHeight, inner, innerHeight, heavyRight);
+        auto innerOuterHeight {height_(child_(inner, heavyRight))};
+        auto b {outerHeight - innerOuterHeight};
+        if (b >= -1 && b <= 1)
+            return rotateOver_nl_(parent, n, c, lightHeight, outerHeight, inner, innerOuterHeight, heavyRight);
+    }
+    //c leans inwards too much for one double rotation: rotate c first
+    return rebalanceTo_nl_(n, c, inner, outerHeight, !heavyRight);
+}
+
+//single rotation: c takes the place of n, n becomes the light side child of c, inner moves over to n
+template <typename T>
+typename concurrentAvlTree<T>::links* concurrentAvlTree<T>::rotate_nl_(links* parent, node* n, node* c, int lightHeight,
+                                                                        int outerHeight, node* inner, int innerHeight, bool heavyRight)
+{
+    auto nodeVersion {version_(n)};
+    auto parentLeft {child_(parent, false)};
+    n->version_.store(nodeVersion | changing_);
+    n->child(heavyRight).store(inner, std::memory_order_release);
+    if (inner != nullptr)
+        inner->parent_.store(n);
+    c->child(!heavyRight).store(n, std::memory_order_release);
+    n->parent_.store(c);
+    parent->child(parentLeft != n).store(c, std::memory_order_release);
+    c->parent_.store(parent);
+    auto nodeHeight {std::max(innerHeight, lightHeight) + 1};
+    n->height_.store(nodeHeight, std::memory_order_relaxed);
+    n->version_.store(nodeVersion + change_);
+    //a routing node left with one child goes right away (its new parent is locked as well), so no height above goes stale
+    auto nodeGone {(inner == nullptr || lightHeight == 0) && !n->present_.load() && unlink_nl_(c, n)};
+    if (nodeGone)
+        --nodeHeight; //the height of the child that took its place
+    auto childHeight {std::max(outerHeight, nodeHeight) + 1};
+    c->height_.store(childHeight, std::memory_order_relaxed);
+    auto childGone {(outerHeight == 0 || nodeHeight == 0) && !c->present_.load() && unlink_nl_(parent, c)};
+    //what is still out of balance: n, then c, else the heights above
+    if (!nodeGone && (innerHeight - lightHeight > 1 || lightHeight - innerHeight > 1))
+        return n;
+    if (!childGone && (outerHeight - nodeHeight > 1 || nodeHeight - outerHeight > 1))
+        return c;
+    auto p {asNode_(parent)};
+    return p == nullptr ? nullptr : fixHeight_nl_(p);
+}
+
+//double rotation: inner takes the place of n, with c and n as its children
+template <typename T>
+typename concurrentAvlTree<T>::links* concurrentAvlTree<T>::rotateOver_nl_(links* parent, node* n, node* c, int lightHeight,
+                                                                            int outerHeight, node* inner, int innerOuterHeight, bool heavyRight)
+{
+    auto nodeVersion {version_(n)};
+    auto childVersion {version_(c)};
+    auto parentLeft {child_(parent, false)};
+    auto innerOuter {child_(inner, heavyRight)};
+    auto innerInner {child_(inner, !heavyRight)};
+    auto innerInnerHeight {height_(innerInner)};
+    n->version_.store(nodeVersion | changing_);
+    c->version_.store(childVersion | changing_);
+    n->child(heavyRight).store(innerInner, std::memory_order_release);
+    if (innerInner != nullptr)
+        innerInner->parent_.store(n);
+    c->child(!heavyRight).store(innerOuter, std::memory_order_release);
+    if (innerOuter != nullptr)
+        innerOuter->parent_.store(c);
+    inner->child(heavyRight).store(c, std::memory_order_release);
+    c->parent_.store(inner);
+    inner->child(!heavyRight).store(n, std::memory_order_release);
+    n->parent_.store(inner);
+    parent->child(parentLeft != n).store(inner, std::memory_order_release);
+    inner->parent_.store(parent);
+    auto nodeHeight {std::max(innerInnerHeight, lightHeight) + 1};
+    auto childHeight {std::max(outerHeight, innerOuterHeight) + 1};
+    n->height_.store(nodeHeight, std::memory_order_relaxed);
+    c->height_.store(childHeight, std::memory_order_relaxed);
+    n->version_.store(nodeVersion + change_);
+    c->version_.store(childVersion + change_);
+    auto nodeGone {(innerInner == nullptr || lightHeight == 0) && !n->present_.load() && unlink_nl_(inner, n)};
+    if (nodeGone)
+        --nodeHeight;
+    if ((outerHeight == 0 || innerOuterHeight == 0) && !c->present_.load() && unlink_nl_(inner, c))
+        --childHeight;
+    inner->height_.store(std::max(nodeHeight, childHeight) + 1, std::memory_order_relaxed);
+    auto innerGone {(nodeHeight == 0 || childHeight == 0) && !inner->present_.load() && unlink_nl_(parent, inner)};
+    if (!nodeGone && (innerInnerHeight - lightHeight > 1 || lightHeight - innerInnerHeight > 1))
+        return n;
+    if (!innerGone && (childHeight - nodeHeight > 1 || nodeHeight - childHeight > 1))
+        return inner;
+    auto p {asNode_(parent)};
+    return p == nullptr ? nullptr : fixHeight_nl_(p);
+}
+
+#endif // CONCURRENTAVLTREE_HPP
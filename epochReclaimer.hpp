@@ -0,0 +1,189 @@
+#ifndef EPOCHRECLAIMER_HPP
+#define EPOCHRECLAIMER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*
+ *	epoch-based reclamation for the structures that are read without locks
+ *	a thread pins the current epoch for the length of an operation (a guard),
+ *	memory that a writer unlinks is retired with the epoch of that moment, and freed only after the epoch
+ *	has advanced twice since: every thread pinned then has unpinned, so no reader can still hold it
+ *	the epoch advances once every pinned thread has seen the current one
+ *
+ *	  epochReclaimer::guard pin;       //no retired object reachable from here is freed before pin goes away
+ *	  epochReclaimer::instance().retire(unlinkedNode);
+ *
+ *	guards nest, every thread has its own list of retired objects (a thread that exits hands its list over)
+ */
+class epochReclaimer
+{
+    struct record;
+public:
+    class guard
+    {
+    public:
+        guard() noexcept : record_(epochReclaimer::instance().pin_()) { }
+        guard(const guard&) = delete;
+        guard& operator=(const guard&) = delete;
+        ~guard() {epochReclaimer::instance().unpin_(record_);}
+    private:
+        record* record_;
+    };
+    epochReclaimer() = default;
+    epochReclaimer(const epochReclaimer&) = delete;
+    epochReclaimer& operator=(const epochReclaimer&) = delete;
+    ~epochReclaimer();
+    static epochReclaimer& instance()
+    {
+        static epochReclaimer reclaimer;
+        return reclaimer;
+    }
+    //delete p once no thread can hold it any more
+    template <typename U>
+    void retire(U* p)
+    {
+        retire(static_cast<void*>(p), [](void* q) noexcept {delete static_cast<U*>(q);});
+    }
+    void retire(void* p, void (*destroy)(void*) noexcept);
+    //try to advance the epoch and free what has become unreachable, retire calls it every so often
+    void collect() noexcept;
+    inline std::uint64_t epoch() const noexcept {return epoch_.load();}
+private:
+    struct retired
+    {
+        void* p_;
+        void (*destroy_)(void*) noexcept;
+        std::uint64_t epoch_;
+    };
+    struct record
+    {
+        std::atomic<std::uint64_t> epoch_ {idle_}; //the pinned epoch, idle_ while unpinned
+        std::atomic<bool> used_ {true}; //owned by a live thread
+        record* next_ {nullptr};
+        int depth_ {}; //nesting of the guards of the owner
+        std::vector<retired> limbo_; //oldest first
+    };
+    //the record of the calling thread, handed back when the thread exits
+    struct owner
+    {
+        record* record_;
+        owner() : record_(epochReclaimer::instance().acquire_()) { }
+        ~owner() {epochReclaimer::instance().release_(record_);}
+    };
+    static constexpr std::uint64_t idle_ {~std::uint64_t{}};
+    static constexpr std::size_t collectEvery_ {128};
+    std::atomic<std::uint64_t> epoch_ {2};
+    std::atomic<record*> records_ {nullptr}; //only grows, records are reused
+    std::mutex orphanMutex_;
+    std::vector<retired> orphans_; //left behind by exited threads
+    static record& local_()
+    {
+        thread_local owner o;
+        return *o.record_;
+    }
+    record* pin_() noexcept;
+    void unpin_(record*) noexcept;
+    record* acquire_();
+    void release_(record*) noexcept;
+    bool advance_() noexcept;
+    static void free_(std::vector<retired>&, std::uint64_t) noexcept;
+};
+
+inline epochReclaimer::~epochReclaimer()
+{
+    //no thread pins any more: free everything
+    for (auto r = records_.load(); r != nullptr; ) {
+        free_(r->limbo_, idle_);
+        auto next {r->next_};
+        delete r;
+        r = next;
+    }
+    free_(orphans_, idle_);
+}
+
+inline epochReclaimer::record* epochReclaimer::pin_() noexcept
+{
+    auto& r {local_()};
+    if (r.depth_++ == 0) {
+        r.epoch_.store(epoch_.load());
+        std::atomic_thread_fence(std::memory_order_seq_cst); //the pin is visible before any read it protects
+    }
+    return &r;
+}
+
+inline void epochReclaimer::unpin_(record* r) noexcept
+{
+    if (--r->depth_ == 0)
+        r->epoch_.store(idle_, std::memory_order_release);
+}
+
+inline void epochReclaimer::retire(void* p, void (*destroy)(void*) noexcept)
+{
+    auto& r {local_()};
+    r.limbo_.push_back({p, destroy, epoch_.load()});
+    if (r.limbo_.size() % collectEvery_ == 0)
+        collect();
+}
+
+inline void epochReclaimer::collect() noexcept
+{
+    advance_();
+    auto safe {epoch_.load()};
+    free_(local_().limbo_, safe);
+    std::unique_lock<std::mutex> lock(orphanMutex_, std::try_to_lock);
+    if (lock.owns_lock() && !orphans_.empty())
+        free_(orphans_, safe);
+}
+
+//one step forward if no thread is pinned behind the current epoch
+inline bool epochReclaimer::advance_() noexcept
+{
+    auto e {epoch_.load()};
+    for (auto r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next_) {
+        auto pinned {r->epoch_.load()};
+        if (pinned != idle_ && pinned != e)
+            return false;
+    }
+    return epoch_.compare_exchange_strong(e, e + 1);
+}
+
+//free the retired objects of at least two epochs before safe (all of them for safe == idle_)
+inline void epochReclaimer::free_(std::vector<retired>& limbo, std::uint64_t safe) noexcept
+{
+    std::size_t n {};
+    while (n != limbo.size() && (safe == idle_ || limbo[n].epoch_ + 2 <= safe))
+        ++n;
+    for (std::size_t i = 0; i != n; ++i)
+        limbo[i].destroy_(limbo[i].p_);
+    limbo.erase(limbo.begin(), limbo.begin() + static_cast<std::ptrdiff_t>(n));
+}
+
+inline epochReclaimer::record* epochReclaimer::acquire_()
+{
+    for (auto r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next_) {
+        bool used {false};
+        if (r->used_.compare_exchange_strong(used, true))
+            return r;
+    }
+    auto r {new record};
+    r->next_ = records_.load(std::memory_order_relaxed);
+    while (!records_.compare_exchange_weak(r->next_, r, std::memory_order_acq_rel))
+        ;
+    return r;
+}
+
+inline void epochReclaimer::release_(record* r) noexcept
+{
+    if (!r->limbo_.empty()) {
+        std::lock_guard<std::mutex> lock(orphanMutex_);
+        orphans_.insert(orphans_.end(), r->limbo_.begin(), r->limbo_.end());
+        r->limbo_.clear();
+    }
+    r->epoch_.store(idle_);
+    r->used_.store(false, std::memory_order_release);
+}
+
+#endif // EPOCHRECLAIMER_HPP
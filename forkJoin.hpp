@@ -0,0 +1,126 @@
+#ifndef FORKJOIN_HPP
+#define FORKJOIN_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+ *	a small fork-join pool for the divide and conquer tree algorithms
+ *	invoke(f1, f2) offers f2 to the workers, runs f1 on the calling thread, then waits for f2
+ *	a waiting thread never blocks: it keeps running queued tasks (its own f2 first, it is the newest one),
+ *	while idle workers steal the oldest tasks, which are the biggest halves of the recursion
+ *	tasks live on the stack of the thread that forked them, so forking allocates nothing
+ *	f1 and f2 must not throw
+ */
+class forkJoinPool
+{
+public:
+    explicit forkJoinPool(unsigned workers)
+    {
+        threads_.reserve(workers);
+        for (unsigned i = 0; i != workers; ++i)
+            threads_.emplace_back([this] {work_();});
+    }
+    forkJoinPool(const forkJoinPool&) = delete;
+    forkJoinPool& operator=(const forkJoinPool&) = delete;
+    ~forkJoinPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        ready_.notify_all();
+        for (auto& t : threads_)
+            t.join();
+    }
+    //one worker per core besides the calling thread
+    static forkJoinPool& instance()
+    {
+        static forkJoinPool pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+        return pool;
+    }
+    inline unsigned workers() const noexcept {return static_cast<unsigned>(threads_.size());}
+    template <typename F1, typename F2>
+    void invoke(F1&& f1, F2&& f2) noexcept;
+private:
+    struct task
+    {
+        void (*run_)(void*) noexcept;
+        void* arg_;
+        std::atomic<bool> done_ {false};
+    };
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::deque<task*> queue_;
+    std::vector<std::thread> threads_;
+    bool stop_ {false};
+    static void execute_(task* t) noexcept
+    {
+        t->run_(t->arg_);
+        t->done_.store(true, std::memory_order_release);
+    }
+    void work_() noexcept;
+    bool help_() noexcept;
+};
+
+template <typename F1, typename F2>
+void forkJoinPool::invoke(F1&& f1, F2&& f2) noexcept
+{
+    if (threads_.empty()) {
+        f1();
+        f2();
+        return;
+    }
+    using callable = std::remove_reference_t<F2>;
+    task forked {[](void* f) noexcept {(*static_cast<callable*>(f))();},
+                 const_cast<void*>(static_cast<const void*>(std::addressof(f2)))};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(&forked);
+    }
+    ready_.notify_one();
+    f1();
+    while (!forked.done_.load(std::memory_order_acquire))
+        if (!help_())
+            std::this_thread::yield(); //a worker is running f2, nothing else to do
+}
+
+//run the newest queued task, false if there is none
+inline bool forkJoinPool::help_() noexcept
+{
+    task* t {nullptr};
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty())
+            return false;
+        t = queue_.back();
+        queue_.pop_back();
+    }
+    execute_(t);
+    return true;
+}
+
+inline void forkJoinPool::work_() noexcept
+{
+    for (;;) {
+        task* t {nullptr};
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] {return stop_ || !queue_.empty();});
+            if (stop_)
+                return;
+            t = queue_.front(); //steal the oldest
+            queue_.pop_front();
+        }
+        execute_(t);
+    }
+}
+
+#endif // FORKJOIN_HPP
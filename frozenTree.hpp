@@ -0,0 +1,186 @@
+#ifndef FROZENTREE_HPP
+#define FROZENTREE_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <type_traits>
+#include <vector>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/*
+ *	immutable search structure built from the elements of a tree (see linkedBinaryTree::freeze)
+ *	the sorted elements are stored in Eytzinger order: the implicit complete tree of a heap,
+ *	the root at [1], the children of [k] at [2k] and [2k+1]
+ *
+ *	                 [1]
+ *	               .     .
+ *	            [2]       [3]          |  - |  1 |  2 |  3 |  4 |  5 |  6 |  7 |
+ *	           .   .     .   .
+ *	         [4]  [5]  [6]   [7]
+ *
+ *	a search is a loop of k = 2k + (element < key) with no branch to mispredict,
+ *	and the descendants of [k] four levels down (for 4-byte keys) share one cache line starting at [16k],
+ *	so that line is prefetched while the next levels are compared
+ *	the elements live in a 64-byte aligned array, so those lines never straddle
+ *	fill_ recurses once per level, the implicit tree is complete
+ */
+template <typename T>
+class frozenTree
+{
+public:
+    frozenTree() = default;
+    //[first, last) must be sorted and free of duplicates
+    template <typename ForwardIt>
+    frozenTree(ForwardIt first, ForwardIt last);
+    inline bool empty() const noexcept {return n_ == 0;}
+    inline std::size_t size() const noexcept {return n_;}
+    bool contains(const T& theElement) const noexcept
+    {
+        auto k {search_(theElement)};
+        return k != 0 && !(theElement < elements_[k]);
+    }
+    //the first element not less than the key, nullptr if there is none
+    const T* lower_bound(const T& theElement) const noexcept
+    {
+        auto k {search_(theElement)};
+        return k == 0 ? nullptr : &elements_[k];
+    }
+    /*
+     *	found[i] = contains(keys[i]) for i in [0, count)
+     *	4-byte integral keys go eight at a time through AVX2 gathers when the build targets it (-mavx2)
+     */
+    void contains(const T* keys, std::size_t count, bool* found) const noexcept;
+    std::vector<T> sorted() const; //the elements in order
+private:
+    //cache line aligned storage
+    template <typename U>
+    struct lineAllocator
+    {
+        using value_type = U;
+        lineAllocator() = default;
+        template <typename V>
+        lineAllocator(const lineAllocator<V>&) noexcept { }
+        U* allocate(std::size_t n) {return static_cast<U*>(::operator new(n * sizeof(U), std::align_val_t{64}));}
+        void deallocate(U* p, std::size_t) noexcept {::operator delete(static_cast<void*>(p), std::align_val_t{64});}
+        template <typename V>
+        bool operator==(const lineAllocator<V>&) const noexcept {return true;}
+    };
+    std::vector<T, lineAllocator<T>> elements_; //[0] is unused, [1, n_] hold the elements
+    std::size_t n_ {};
+    static constexpr std::size_t lineElements_ {std::max<std::size_t>(64 / sizeof(T), 1)};
+    static void prefetch_(const void* p) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p);
+#else
+        (void)p;
+#endif
+    }
+    //Eytzinger index of the first element not less than the key, 0 if there is none
+    std::size_t search_(const T& theElement) const noexcept
+    {
+        std::size_t k {1};
+        const T* e {elements_.data()};
+        while (k <= n_) {
+            prefetch_(e + std::min(k * lineElements_, n_));
+            k = 2 * k + (e[k] < theElement);
+        }
+        //the last left turn is the answer: drop the right turns after it, then the left turn itself
+        return k >> (std::countr_one(k) + 1);
+    }
+    template <typename ForwardIt>
+    void fill_(std::size_t, ForwardIt&);
+};
+
+template <typename T>
+template <typename ForwardIt>
+frozenTree<T>::frozenTree(ForwardIt first, ForwardIt last)
+    : n_(static_cast<std::size_t>(std::distance(first, last)))
+{
+    elements_.resize(n_ + 1);
+    fill_(1, first);
+}
+
+//in-order over the implicit tree, so the k-th visited slot takes the k-th element
+template <typename T>
+template <typename ForwardIt>
+void frozenTree<T>::fill_(std::size_t k, ForwardIt& it)
+{
+    if (k > n_)
+        return;
+    fill_(2 * k, it);
+    elements_[k] = *it;
+    ++it;
+    fill_(2 * k + 1, it);
+}
+
+template <typename T>
+std::vector<T> frozenTree<T>::sorted() const
+{
+    std::vector<T> v;
+    v.reserve(n_);
+    //in-order over the implicit tree without recursion: leftmost descent, then successor steps
+    std::size_t k {1};
+    if (n_ == 0)
+        return v;
+    while (2 * k <= n_)
+        k *= 2;
+    for (std::size_t i = 0; i != n_; ++i) {
+        v.push_back(elements_[k]);
+        if (2 * k + 1 <= n_) { //the minimum of the right subtree
+            k = 2 * k + 1;
+            while (2 * k <= n_)
+                k *= 2;
+        } else //climb while coming from a right child, then once more
+            k >>= std::countr_one(k) + 1;
+    }
+    return v;
+}
+
+template <typename T>
+void frozenTree<T>::contains(const T* keys, std::size_t count, bool* found) const noexcept
+{
+    std::size_t i {};
+#ifdef __AVX2__
+    if constexpr (std::is_integral_v<T> && sizeof(T) == 4) {
+        if (n_ != 0 && n_ < std::numeric_limits<std::int32_t>::max() / 2) {
+            /*
+             *	every lane runs the same number of levels, a lane that leaves the tree early (k > n)
+             *	keeps turning right, which the final decoding strips again together with its real right turns
+             *	unsigned keys are compared as signed after flipping the sign bit
+             */
+            const auto levels {static_cast<int>(std::bit_width(n_))};
+            const auto* base {reinterpret_cast<const int*>(elements_.data())};
+            const __m256i n {_mm256_set1_epi32(static_cast<int>(n_))};
+            const __m256i one {_mm256_set1_epi32(1)};
+            const __m256i flip {_mm256_set1_epi32(std::is_signed_v<T> ? 0 : std::numeric_limits<std::int32_t>::min())};
+            alignas(32) std::uint32_t ks[8];
+            for (; i + 8 <= count; i += 8) {
+                const __m256i key {_mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip)};
+                __m256i k {one};
+                for (int level = 0; level != levels; ++level) {
+                    const __m256i outside {_mm256_cmpgt_epi32(k, n)};
+                    const __m256i e {_mm256_xor_si256(_mm256_i32gather_epi32(base, _mm256_min_epi32(k, n), 4), flip)};
+                    const __m256i right {_mm256_or_si256(_mm256_cmpgt_epi32(key, e), outside)}; //-1 or 0
+                    k = _mm256_sub_epi32(_mm256_add_epi32(k, k), right);
+                }
+                _mm256_store_si256(reinterpret_cast<__m256i*>(ks), k);
+                for (int lane = 0; lane != 8; ++lane) {
+                    auto r {ks[lane] >> (std::countr_one(ks[lane]) + 1)};
+                    found[i + lane] = r != 0 && !(keys[i + lane] < elements_[r]);
+                }
+            }
+        }
+    }
+#endif
+    for (; i != count; ++i)
+        found[i] = contains(keys[i]);
+}
+
+#endif // FROZENTREE_HPP
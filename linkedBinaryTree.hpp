@@ -1,261 +1,980 @@
 #ifndef LINKEDBINARYTREE_HPP
 #define LINKEDBINARYTREE_HPP
 
-#include <functional>
 #include <vector>
-#include <deque>
 #include <iterator>
 #include <algorithm>
 #include <iostream>
 #include <utility>
+#include <type_traits>
+#include <string>
+#include <bit>
 #include "binaryTree.hpp"
 #include "binaryTreeNode.hpp"
+#include "frozenTree.hpp"
+#include "treeSnapshot.hpp"
 
 using std::vector;
 
-template <typename T>
-class linkedBinaryTree : public binaryTree<binaryTreeNode<T>>
+template <typename T, typename Alloc = heapAllocator, typename Augment = noAugment>
+class linkedBinaryTree : public binaryTree<binaryTreeNode<T, Alloc, Augment>>
 {
-    using node = binaryTreeNode<T>;
-    using nodePtr = std::unique_ptr<node>;
-    using VisitFunc = std::function<void(nodePtr&)>;
+    using node = binaryTreeNode<T, Alloc, Augment>;
+    using nodePtr = typename node::nodePtr;
 
 public:
+    //in-order iterator over the elements, elements are read-only through it
+    class iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+        iterator() = default;
+        reference operator*() const noexcept {return node_->element_;}
+        pointer operator->() const noexcept {return &node_->element_;}
+        iterator& operator++() noexcept
+        {
+            node_ = next_(node_);
+            return *this;
+        }
+        iterator operator++(int) noexcept
+        {
+            auto tmp {*this};
+            ++*this;
+            return tmp;
+        }
+        iterator& operator--() noexcept
+        {
+            node_ = (node_ == nullptr) ? last_(tree_->root_.get()) : prev_(node_); //--end() is the maximum
+            return *this;
+        }
+        iterator operator--(int) noexcept
+        {
+            auto tmp {*this};
+            --*this;
+            return tmp;
+        }
+        bool operator==(const iterator& rhs) const noexcept {return node_ == rhs.node_;}
+    private:
+        friend class linkedBinaryTree;
+        const node* node_ {nullptr}; //nullptr for end()
+        const linkedBinaryTree* tree_ {nullptr};
+        iterator(const node* theNode, const linkedBinaryTree* theTree) noexcept : node_(theNode), tree_(theTree) { }
+    };
+    using const_iterator = iterator;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = reverse_iterator;
+
     linkedBinaryTree() = default;
-    linkedBinaryTree(const linkedBinaryTree<T>&);
+    linkedBinaryTree(const linkedBinaryTree<T, Alloc, Augment>&);
+    /*
+     *	a move hands the nodes (and with poolAllocator the pool holding them) over, nothing is copied,
+     *	iterators keep pointing at the same elements, only --end() of the old tree is lost
+     */
+    linkedBinaryTree(linkedBinaryTree<T, Alloc, Augment>&&) noexcept;
+    linkedBinaryTree& operator=(const linkedBinaryTree<T, Alloc, Augment>&);
+    linkedBinaryTree& operator=(linkedBinaryTree<T, Alloc, Augment>&&) noexcept;
     ~linkedBinaryTree();
     inline bool empty() const noexcept override {return root_ == nullptr;}
     inline int height() noexcept override {return height_(root_);}
     int height(const nodePtr& r) noexcept {return height_(r);}
     int nodeCount() noexcept override;
-    bool find(const T theElement) noexcept {return find_(theElement, root_);}
-    virtual nodePtr& insert(const T, nodePtr&) noexcept;
-    virtual bool erase(const T, nodePtr&) noexcept;
+    bool find(const T& theElement) noexcept {return find_(theElement, root_);}
+    template <typename K> requires transparentKey<K, T>
+    bool find(const K& theKey) noexcept {return find_(theKey, root_);}
+    //insert copies an lvalue once into its node and moves an rvalue there, the trees derived override both
+    virtual nodePtr& insert(const T& theElement, nodePtr& t) noexcept {return insert_(theElement, t);}
+    virtual nodePtr& insert(T&& theElement, nodePtr& t) noexcept {return insert_(std::move(theElement), t);}
+    //build the element from args in place of a copy, then insert it as an rvalue (it is dropped if it is there already)
+    template <typename... Args>
+    nodePtr& emplace(nodePtr& t, Args&&... args) {return insert(T(std::forward<Args>(args)...), t);}
+    virtual bool erase(const T&, nodePtr&) noexcept;
+    //replace the content with a height-balanced tree in O(n), [first, last) must be sorted and free of duplicates
+    template <typename ForwardIt>
+    void build(ForwardIt first, ForwardIt last);
+    void build(vector<T> elements); //sorts and removes duplicates first
     inline nodePtr& root() noexcept {return root_;}
-    inline T value(nodePtr& theNode) const noexcept {return theNode->element_;}
-    inline void setValue(nodePtr& theNode, T theElement) noexcept {theNode->element_ = theElement;}
-    vector<int> levelInfo() noexcept;
-    void preOrder(const VisitFunc& theVisit) noexcept
+    inline const nodePtr& root() const noexcept {return root_;}
+    inline const T& value(const nodePtr& theNode) const noexcept {return theNode->element_;}
+    inline void setValue(nodePtr& theNode, T theElement) noexcept {theNode->element_ = std::move(theElement);}
+    /*
+     *	iterators point at nodes, so rotations keep them valid
+     *	erase invalidates the iterator of the erased element, and of the element lifted
+     *	into its node when the erased node had two children
+     */
+    iterator begin() const noexcept {return iterator(first_(root_.get()), this);}
+    iterator end() const noexcept {return iterator(nullptr, this);}
+    reverse_iterator rbegin() const noexcept {return reverse_iterator(end());}
+    reverse_iterator rend() const noexcept {return reverse_iterator(begin());}
+    iterator lower_bound(const T& theElement) const noexcept {return lowerBound_(theElement);} //first element not less than the key
+    iterator upper_bound(const T& theElement) const noexcept {return upperBound_(theElement);} //first element greater than the key
+    std::pair<iterator, iterator> equal_range(const T& theElement) const noexcept
+    {
+        return {lowerBound_(theElement), upperBound_(theElement)};
+    }
+    template <typename K> requires transparentKey<K, T>
+    iterator lower_bound(const K& theKey) const noexcept {return lowerBound_(theKey);}
+    template <typename K> requires transparentKey<K, T>
+    iterator upper_bound(const K& theKey) const noexcept {return upperBound_(theKey);}
+    template <typename K> requires transparentKey<K, T>
+    std::pair<iterator, iterator> equal_range(const K& theKey) const noexcept
+    {
+        return {lowerBound_(theKey), upperBound_(theKey)};
+    }
+    /*
+     *	order statistics, available with sizeAugment or summaryAugment
+     *	rank: the number of elements less than the key
+     *	select: the k-th smallest element (k begins from 0), end() if k is out of range
+     */
+    int rank(const T&) const noexcept;
+    iterator select(int) const noexcept;
+    //combine the summaries of the elements in [lo, hi] in order, available with summaryAugment
+    auto aggregate(const T& lo, const T& hi) const noexcept;
+    vector<int> levelInfo() const;
+    int width() const; //node count of the widest level
+    //an immutable copy of the elements laid out for fast searching, see frozenTree
+    frozenTree<T> freeze() const
+    {
+        vector<T> elements;
+        if constexpr (sized_) //the count is O(1) with the sizes, without them a counting walk costs more than the growth
+            elements.reserve(static_cast<std::size_t>(size_(root_)));
+        inOrder([&elements](const node& p) {elements.push_back(p.element_);});
+        return frozenTree<T>(elements.begin(), elements.end());
+    }
+    /*
+     *	binary snapshot of the tree, see treeSnapshot.hpp for the format, T must be trivially copyable
+     *	saveSnapshot writes the keys in order, and the shape too with withShape; false if the file cannot be written
+     *	loadSnapshot replaces the content in O(n) without a comparison: the shape comes back node for node,
+     *	the keys alone (or keepShape false) make the balanced tree of build
+     *	false, the tree unchanged, if the file is not a snapshot of T (always, if T is not trivially copyable)
+     *	virtual: a tree whose shape carries its balance (avlTree, redBlackTree) always rebuilds it balanced
+     */
+    bool saveSnapshot(const std::string& path, bool withShape = false) const;
+    virtual bool loadSnapshot(const std::string& path, bool keepShape = true);
+    /*
+     *	traversals, the visitor sees node& (const node& through a const tree), see visitNode for the protocol
+     *	levelOrder also takes a visitor of (node, level No., position in the level), both begin from 0
+     *	the visitor is a template parameter, so it is inlined and nothing is stored in the tree:
+     *	walks may nest, and const walks of one tree may run in several threads at once
+     *	no walk recurses, the pending nodes are kept in a buffer of the tree (a local one for const walks)
+     */
+    template <typename Visit>
+    bool preOrder(Visit&& theVisit)
+    {
+        return borrow_(stack_, [&](auto& stack) {return preOrder_<node>(root_.get(), theVisit, stack);});
+    }
+    template <typename Visit>
+    bool preOrder(Visit&& theVisit) const
+    {
+        vector<const node*> stack;
+        return preOrder_<const node>(root_.get(), theVisit, stack);
+    }
+    template <typename Visit>
+    bool inOrder(Visit&& theVisit)
+    {
+        return borrow_(stack_, [&](auto& stack) {return inOrder_<node>(root_.get(), theVisit, stack);});
+    }
+    template <typename Visit>
+    bool inOrder(Visit&& theVisit) const
+    {
+        vector<const node*> stack;
+        return inOrder_<const node>(root_.get(), theVisit, stack);
+    }
+    template <typename Visit>
+    bool postOrder(Visit&& theVisit)
     {
-        visit_ = theVisit;
-        preOrder_(root_);
+        return borrow_(stack_, [&](auto& stack) {return postOrder_<node>(root_.get(), theVisit, stack);});
     }
-    void inOrder(const VisitFunc& theVisit) noexcept
+    template <typename Visit>
+    bool postOrder(Visit&& theVisit) const
     {
-        visit_ = theVisit;
-        inOrder_(root_);
+        vector<const node*> stack;
+        return postOrder_<const node>(root_.get(), theVisit, stack);
     }
-    void postOrder(const VisitFunc& theVisit) noexcept
+    template <typename Visit>
+    bool levelOrder(Visit&& theVisit)
     {
-        visit_ = theVisit;
-        postOrder_(root_);
+        return borrow_(ring_, [&](auto& ring) {return levelOrder_<node>(root_.get(), theVisit, ring);});
     }
-    void levelOrder(const VisitFunc& theVisit) noexcept
+    template <typename Visit>
+    bool levelOrder(Visit&& theVisit) const
     {
-        visit_ = theVisit;
-        levelOrder_(root_);
-    }
-    inline nodePtr& findMax(nodePtr& t) const noexcept {return (t->rightChild_ == nullptr) ? t : findMax(t->rightChild_);
-                               }
-    inline nodePtr& findMin(nodePtr& t) const noexcept {return (t->leftChild_ == nullptr) ? t : findMin(t->leftChild_);
-                               }
-    friend std::istream& operator>> (std::istream& is, linkedBinaryTree<T>& t) {
+        vector<const node*> ring;
+        return levelOrder_<const node>(root_.get(), theVisit, ring);
+    }
+    inline nodePtr& findMax(nodePtr& t) const noexcept
+    {
+        auto p {&t};
+        while ((*p)->rightChild_ != nullptr)
+            p = &(*p)->rightChild_;
+        return *p;
+    }
+    inline nodePtr& findMin(nodePtr& t) const noexcept
+    {
+        auto p {&t};
+        while ((*p)->leftChild_ != nullptr)
+            p = &(*p)->leftChild_;
+        return *p;
+    }
+    friend std::istream& operator>> (std::istream& is, linkedBinaryTree<T, Alloc, Augment>& t) {
         T theElement;
         is >> theElement;
         if (is)
-            t.insert(theElement, t.root());
+            t.insert(std::move(theElement), t.root());
         return is;
     }
+protected:
+    //recompute the cached height and the augmented fields of t from its children (children must be up to date)
+    static void updateNode(const nodePtr& t) noexcept {updateNode(t.get());}
+    static void updateNode(node*) noexcept;
+    //refresh t and its ancestors, up to (not including) stop
+    static void updatePath(node* t, const node* stop) noexcept;
+    //every node of the tree comes from here
+    template <typename... Args>
+    nodePtr makeNode(Args&&... args)
+    {
+        auto t {pool_.make(std::forward<Args>(args)...)};
+        updateNode(t);
+        return t;
+    }
+    //t has at most one child: drop t and move that child up into its place
+    static void replaceWithChild(nodePtr& t) noexcept
+    {
+        auto parent {t->parent_};
+        t = std::move((t->leftChild_ != nullptr) ? t->leftChild_ : t->rightChild_);
+        if (t != nullptr)
+            t->parent_ = parent;
+    }
+    //called once build or loadSnapshot has put in a whole new tree, for the trees derived to set up what they keep in the nodes
+    virtual void afterBuild_() noexcept { }
+    //take over the node storage of other, so its nodes may be linked into this tree
+    void adoptPool(linkedBinaryTree& other) noexcept {pool_.adopt(other.pool_);}
 private:
+    typename Alloc::template pool<node> pool_; //declared before root_, so it outlives every node
     nodePtr root_;
-    VisitFunc visit_;
     vector<T> preSeq_;
     vector<T> inSeq_;
     vector<T> postSeq_;
-    vector<int> levelInfo_;
-    int height_(const nodePtr&) noexcept;
-    bool find_(const T, const nodePtr&) noexcept;
-    void preOrder_(nodePtr&) noexcept;
-    void inOrder_(nodePtr&) noexcept;
-    void postOrder_(nodePtr&) noexcept;
-    void levelOrder_(const nodePtr&) noexcept;
+    vector<node*> stack_; //stack storage reused by the non-const depth-first walks
+    vector<node*> ring_; //queue storage reused by the non-const level-order walks
+    static int height_(const nodePtr& t) noexcept {return t == nullptr ? 0 : t->height_;}
+    static constexpr bool sized_ {requires (const node& t) {t.size_;}};
+    static int size_(const nodePtr& t) noexcept
+    {
+        if constexpr (sized_)
+            return t == nullptr ? 0 : t->size_;
+        else
+            return 0;
+    }
+    template <typename K>
+    bool find_(const K&, const nodePtr&) noexcept;
+    template <typename K>
+    iterator lowerBound_(const K&) const noexcept;
+    template <typename K>
+    iterator upperBound_(const K&) const noexcept;
+    template <typename E>
+    nodePtr& insert_(E&&, nodePtr&) noexcept;
+    void release_() noexcept; //drop every node, the destructor and the move assignment
+    //run walk(buffer) with the buffer taken out of the tree meanwhile, so a nested walk gets one of its own
+    template <typename Walk>
+    static bool borrow_(vector<node*>& buffer, Walk&& walk)
+    {
+        auto taken {std::move(buffer)};
+        auto done {walk(taken)};
+        buffer = std::move(taken);
+        return done;
+    }
+    template <typename Node, typename Visit>
+    static bool preOrder_(Node*, Visit&, vector<Node*>&);
+    template <typename Node, typename Visit>
+    static bool inOrder_(Node*, Visit&, vector<Node*>&);
+    template <typename Node, typename Visit>
+    static bool postOrder_(Node*, Visit&, vector<Node*>&);
+    template <typename Node, typename Visit>
+    static bool levelOrder_(Node*, Visit&, vector<Node*>&);
+    nodePtr clone_(const nodePtr&);
+    template <typename ForwardIt>
+    nodePtr build_(ForwardIt&, std::size_t);
+    nodePtr buildShape_(snapshotKeys<T>, const unsigned char*, std::size_t);
+    static void clear_(nodePtr&) noexcept;
+    static const node* first_(const node*) noexcept;
+    static const node* last_(const node*) noexcept;
+    static const node* next_(const node*) noexcept;
+    static const node* prev_(const node*) noexcept;
 };
 
-template <typename T>
-linkedBinaryTree<T>::linkedBinaryTree(const linkedBinaryTree<T>& rhs)
+template <typename T, typename Alloc, typename Augment>
+linkedBinaryTree<T, Alloc, Augment>::linkedBinaryTree(const linkedBinaryTree<T, Alloc, Augment>& rhs)
+    : preSeq_(rhs.preSeq_), inSeq_(rhs.inSeq_), postSeq_(rhs.postSeq_)
 {
     //deep copy
-    root_ = std::make_unique<node>(rhs.root_);
-    visit_ = rhs.visit_;
-    preSeq_.clear();
-    preSeq_.reserve(rhs.preSeq_.size());
-    std::copy(rhs.preSeq_.cbegin(), rhs.preSeq_.cend(), preSeq_.begin());
-    inSeq_.clear();
-    inSeq_.reserve(rhs.inSeq_.size());
-    std::copy(rhs.inSeq_.cbegin(), rhs.inSeq_.cend(), inSeq_.begin());
-    postSeq_.clear();
-    postSeq_.reserve(rhs.postSeq_.size());
-    std::copy(rhs.postSeq_.cbegin(), rhs.postSeq_.cend(), postSeq_.begin());
-    levelInfo_.clear();
-    levelInfo_.reserve(rhs.levelInfo_.size());
-    std::copy(rhs.levelInfo_.cbegin(), rhs.levelInfo_.cend(), levelInfo_.begin());
+    root_ = clone_(rhs.root_);
 }
 
+template <typename T, typename Alloc, typename Augment>
+linkedBinaryTree<T, Alloc, Augment>::linkedBinaryTree(linkedBinaryTree<T, Alloc, Augment>&& rhs) noexcept
+    : pool_(std::move(rhs.pool_)), root_(std::move(rhs.root_)), preSeq_(std::move(rhs.preSeq_)),
+      inSeq_(std::move(rhs.inSeq_)), postSeq_(std::move(rhs.postSeq_))
+{
+}
 
-template <typename T>
-linkedBinaryTree<T>::~linkedBinaryTree()
+//copy first, so this is unchanged if the copy throws
+template <typename T, typename Alloc, typename Augment>
+linkedBinaryTree<T, Alloc, Augment>& linkedBinaryTree<T, Alloc, Augment>::operator=(const linkedBinaryTree<T, Alloc, Augment>& rhs)
 {
-    root_ = nullptr;//unique_ptr
+    if (this != &rhs)
+        *this = linkedBinaryTree(rhs);
+    return *this;
 }
 
-template <typename T>
-int linkedBinaryTree<T>::height_(const nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+linkedBinaryTree<T, Alloc, Augment>& linkedBinaryTree<T, Alloc, Augment>::operator=(linkedBinaryTree<T, Alloc, Augment>&& rhs) noexcept
 {
-    if (t == nullptr)
-        return 0;
+    if (this != &rhs) {
+        release_(); //the nodes go before the pool they live in
+        pool_ = std::move(rhs.pool_);
+        root_ = std::move(rhs.root_);
+        preSeq_ = std::move(rhs.preSeq_);
+        inSeq_ = std::move(rhs.inSeq_);
+        postSeq_ = std::move(rhs.postSeq_);
+    }
+    return *this;
+}
+
+template <typename T, typename Alloc, typename Augment>
+linkedBinaryTree<T, Alloc, Augment>::~linkedBinaryTree()
+{
+    release_();
+}
+
+template <typename T, typename Alloc, typename Augment>
+void linkedBinaryTree<T, Alloc, Augment>::release_() noexcept
+{
+    if constexpr (Alloc::releasesInBulk && std::is_trivially_destructible_v<T>)
+        root_.release(); //nothing to run per node, the pool frees whole chunks
+    else
+        clear_(root_);
+}
+
+/*
+ *	copy without recursion: walk the source and the copy side by side through the parent links,
+ *	a child of the copy is made the first time the walk goes down to it,
+ *	and a node of the copy is refreshed when the walk leaves it upwards (its children are complete then)
+ */
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr linkedBinaryTree<T, Alloc, Augment>::clone_(const nodePtr& from)
+{
+    if (from == nullptr)
+        return nullptr;
+    auto copy {makeNode(from->element_)};
+    copy->red_ = from->red_;
+    try {
+        const node* s {from.get()};
+        node* c {copy.get()};
+        for (;;) {
+            if (s->leftChild_ != nullptr && c->leftChild_ == nullptr) {
+                c->leftChild_ = makeNode(s->leftChild_->element_);
+                c->leftChild_->parent_ = c;
+                c->leftChild_->red_ = s->leftChild_->red_;
+                s = s->leftChild_.get();
+                c = c->leftChild_.get();
+            } else if (s->rightChild_ != nullptr && c->rightChild_ == nullptr) {
+                c->rightChild_ = makeNode(s->rightChild_->element_);
+                c->rightChild_->parent_ = c;
+                c->rightChild_->red_ = s->rightChild_->red_;
+                s = s->rightChild_.get();
+                c = c->rightChild_.get();
+            } else {
+                updateNode(c);
+                if (s == from.get())
+                    break;
+                s = s->parent_;
+                c = c->parent_;
+            }
+        }
+    } catch (...) {
+        clear_(copy); //the partial copy may be deep as well
+        throw;
+    }
+    return copy;
+}
+
+/*
+ *	free every node without recursion (a degenerate tree would overflow the stack)
+ *	rotate left children up until the root has none, then drop the root
+ *
+ *	     t            l
+ *	    . .          . .
+ *	   l   C  ==>   A   t
+ *	  . .              . .
+ *	 A   B            B   C
+ */
+template <typename T, typename Alloc, typename Augment>
+void linkedBinaryTree<T, Alloc, Augment>::clear_(nodePtr& root) noexcept
+{
+    while (root != nullptr) {
+        if (root->leftChild_ != nullptr) {
+            auto l {std::move(root->leftChild_)};
+            root->leftChild_ = std::move(l->rightChild_);
+            l->rightChild_ = std::move(root);
+            root = std::move(l);
+        } else
+            root = std::move(root->rightChild_);
+    }
+}
+
+template <typename T, typename Alloc, typename Augment>
+template <typename ForwardIt>
+void linkedBinaryTree<T, Alloc, Augment>::build(ForwardIt first, ForwardIt last)
+{
+    clear_(root_);
+    root_ = build_(first, static_cast<std::size_t>(std::distance(first, last)));
+    afterBuild_();
+}
+
+template <typename T, typename Alloc, typename Augment>
+void linkedBinaryTree<T, Alloc, Augment>::build(vector<T> elements)
+{
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+    build(elements.cbegin(), elements.cend());
+}
+
+/*
+ *	build the subtree of the next n elements in order: left half, middle, right half
+ *	the halves differ by at most one node, so the result is an AVL tree as well
+ */
+template <typename T, typename Alloc, typename Augment>
+template <typename ForwardIt>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr linkedBinaryTree<T, Alloc, Augment>::build_(ForwardIt& it, std::size_t n)
+{
+    if (n == 0)
+        return nullptr;
+    auto left {build_(it, n / 2)};
+    auto t {makeNode(*it)};
+    ++it;
+    t->rightChild_ = build_(it, n - n / 2 - 1);
+    t->leftChild_ = std::move(left);
+    if (t->leftChild_ != nullptr)
+        t->leftChild_->parent_ = t.get();
+    if (t->rightChild_ != nullptr)
+        t->rightChild_->parent_ = t.get();
+    updateNode(t);
+    return t;
+}
+
+template <typename T, typename Alloc, typename Augment>
+bool linkedBinaryTree<T, Alloc, Augment>::saveSnapshot(const std::string& path, bool withShape) const
+{
+    static_assert(std::is_trivially_copyable_v<T> && std::endian::native == std::endian::little,
+                  "a snapshot holds the bytes of T as they are, little endian");
+    snapshotHeader header {};
+    std::memcpy(header.magic, snapshotHeader::magicBytes, sizeof(header.magic));
+    header.version = snapshotHeader::currentVersion;
+    header.keyBytes = sizeof(T);
+    header.flags = withShape ? snapshotHeader::shape : 0;
+    snapshotWriter out(path);
+    inOrder([&](const node& p) {
+        out.write(&p.element_, sizeof(T));
+        ++header.count;
+    });
+    if (withShape) {
+        unsigned char bits {};
+        std::uint64_t i {};
+        preOrder([&](const node& p) {
+            bits |= static_cast<unsigned char>(((p.leftChild_ != nullptr ? 1u : 0u) | (p.rightChild_ != nullptr ? 2u : 0u)) << (i % 4 * 2));
+            if (++i % 4 == 0) {
+                out.write(&bits, 1);
+                bits = 0;
+            }
+        });
+        if (i % 4 != 0)
+            out.write(&bits, 1);
+    }
+    return out.close(header);
+}
+
+template <typename T, typename Alloc, typename Augment>
+bool linkedBinaryTree<T, Alloc, Augment>::loadSnapshot(const std::string& path, bool keepShape)
+{
+    //virtual, so it is there for every T: one that a snapshot cannot hold loads nothing
+    if constexpr (!std::is_trivially_copyable_v<T> || std::endian::native != std::endian::little)
+        return false;
     else {
+        mappedFile file(path);
+        snapshotHeader header;
+        if (file.data() == nullptr || file.size() < sizeof(header))
+            return false;
+        std::memcpy(&header, file.data(), sizeof(header));
+        if (header.fileSize<T>() != file.size())
+            return false;
+        auto n {static_cast<std::size_t>(header.count)};
+        snapshotKeys<T> keys(file.data() + sizeof(header));
+        nodePtr t;
+        if (keepShape && (header.flags & snapshotHeader::shape) != 0) {
+            t = buildShape_(keys, file.data() + sizeof(header) + n * sizeof(T), n);
+            if (t == nullptr && n != 0)
+                return false;
+        } else
+            t = build_(keys, n);
+        clear_(root_);
+        root_ = std::move(t);
+        afterBuild_();
+        return true;
+    }
+}
+
+/*
+ *	rebuild the shape of a snapshot in one pass: the shape comes in pre-order and the keys in order,
+ *	so a node is made once its left subtree is done
+ *	stack holds the nodes waiting for a subtree: without a node yet, the left subtree of the next one
+ *	is under way (its shape bits kept aside), with one, its right subtree
+ *	nullptr if the shape does not describe n nodes
+ */
+template <typename T, typename Alloc, typename Augment>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr linkedBinaryTree<T, Alloc, Augment>::buildShape_(snapshotKeys<T> keys, const unsigned char* shape, std::size_t n)
+{
+    struct pending
+    {
+        nodePtr t;
+        unsigned bits;
+    };
+    vector<pending> stack;
+    std::size_t read {};
+    auto next {[&]() {
+        auto bits {(shape[read / 4] >> (read % 4 * 2)) & 3u};
+        ++read;
+        return bits;
+    }};
+    nodePtr done; //the subtree finished last
+    auto fail {[&]() {
+        for (auto& p : stack)
+            clear_(p.t);
+        clear_(done);
+        return nodePtr {};
+    }};
+    if (n == 0)
+        return nullptr;
+    auto bits {next()};
+    for (;;) {
+        while ((bits & 1u) != 0) { //a left child: its subtree comes first
+            if (read == n)
+                return fail();
+            stack.push_back({nullptr, bits});
+            bits = next();
+        }
+        //the node of bits, its left subtree in done
+        for (;;) {
+            auto t {makeNode(*keys)};
+            ++keys;
+            t->leftChild_ = std::move(done);
+            if (t->leftChild_ != nullptr)
+                t->leftChild_->parent_ = t.get();
+            if ((bits & 2u) != 0) {
+                if (read == n)
+                    return fail();
+                stack.push_back({std::move(t), bits});
+                bits = next();
+                break;
+            }
+            updateNode(t);
+            done = std::move(t);
+            while (!stack.empty() && stack.back().t != nullptr) { //done is the right subtree of the node on top
+                auto& p {stack.back().t};
+                p->rightChild_ = std::move(done);
+                p->rightChild_->parent_ = p.get();
+                updateNode(p);
+                done = std::move(p);
+                stack.pop_back();
+            }
+            if (stack.empty())
+                return read == n ? std::move(done) : fail();
+            bits = stack.back().bits; //done is the left subtree of the next node
+            stack.pop_back();
+        }
+    }
+}
+
+template <typename T, typename Alloc, typename Augment>
+void linkedBinaryTree<T, Alloc, Augment>::updateNode(node* t) noexcept
+{
+    if (t != nullptr) {
         auto hl {height_(t->leftChild_)}; //height for the left
         auto hr {height_(t->rightChild_)}; //height for the right
-        return hl > hr ? ++hl : ++hr;
+        t->height_ = hl > hr ? ++hl : ++hr;
+        Augment::pull(*t);
     }
 }
 
-template <typename T>
-int linkedBinaryTree<T>::nodeCount() noexcept
+template <typename T, typename Alloc, typename Augment>
+int linkedBinaryTree<T, Alloc, Augment>::nodeCount() noexcept
 {
+    if constexpr (sized_)
+        return size_(root_);
     int cnt {};
-    this->postOrder([&cnt](nodePtr& t)
-    {
-        if (t != nullptr)
-            ++cnt;
-    });
+    preOrder([&cnt](const node&) {++cnt;});
     return cnt;
 }
 
-template <typename T>
-bool linkedBinaryTree<T>::find_(const T theElement, const nodePtr& t) noexcept
+/*
+ *	without an augmentation only the heights change, and they stop changing at the first node whose height
+ *	stays the same, so the walk ends there; augmented fields (sizes, summaries) change all the way up
+ */
+template <typename T, typename Alloc, typename Augment>
+void linkedBinaryTree<T, Alloc, Augment>::updatePath(node* t, const node* stop) noexcept
 {
-    if (t == nullptr) return false;
-    if (t->element_ == theElement)
-        return true;
-    else if (t->element_ < theElement)
-        return find_(theElement, t->rightChild_);
-    else
-        return find_(theElement, t->leftChild_);
+    for (; t != stop; t = t->parent_) {
+        auto old {t->height_};
+        updateNode(t);
+        if constexpr (std::is_same_v<Augment, noAugment>)
+            if (t->height_ == old)
+                return;
+    }
 }
 
-template <typename T>
-std::unique_ptr<binaryTreeNode<T>>& linkedBinaryTree<T>::insert(const T theElement, nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+template <typename K>
+bool linkedBinaryTree<T, Alloc, Augment>::find_(const K& theKey, const nodePtr& root) noexcept
 {
-    if (t == nullptr){
-        t = std::make_unique<node>(theElement);
-        return t;
+    for (auto t = root.get(); t != nullptr; ) {
+        if (t->element_ == theKey)
+            return true;
+        t = ((t->element_ < theKey) ? t->rightChild_ : t->leftChild_).get(); //a select, not a branch to mispredict
     }
-    else if (theElement < t->element_)
-        return insert(theElement, t->leftChild_);
-    else if (theElement > t->element_)
-        return insert(theElement, t->rightChild_);
-    else
-        return t;
+    return false;
 }
 
-template <typename T>
-bool linkedBinaryTree<T>::erase(const T theElement, nodePtr& t) noexcept
+/*
+ *	the descent and the refresh of the path back up are both loops, so a degenerate tree cannot overflow the stack
+ *	E is const T& or T, the element is read until the new node is made from it, which is the last use
+ */
+template <typename T, typename Alloc, typename Augment>
+template <typename E>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& linkedBinaryTree<T, Alloc, Augment>::insert_(E&& theElement, nodePtr& t) noexcept
+{
+    auto link {&t};
+    node* parent {t == nullptr ? nullptr : t->parent_};
+    while (*link != nullptr) {
+        parent = link->get();
+        if (theElement < parent->element_)
+            link = &parent->leftChild_;
+        else if (parent->element_ < theElement)
+            link = &parent->rightChild_;
+        else
+            return *link; //the element was in the tree already
+    }
+    *link = makeNode(std::forward<E>(theElement));
+    (*link)->parent_ = parent;
+    updatePath(parent, nullptr); //up to the real root: t may be a subtree link, its ancestors change height too
+    return *link;
+}
+
+template <typename T, typename Alloc, typename Augment>
+bool linkedBinaryTree<T, Alloc, Augment>::erase(const T& theElement, nodePtr& t) noexcept
 {
     if (t == nullptr)
         return false;
-    else {
-        if (theElement < t->element_)
-            return erase(theElement, t->leftChild_);
-        else if (theElement > t->element_)
-            return erase(theElement, t->rightChild_);
-        else if (t->leftChild_ != nullptr && t->rightChild_ != nullptr) { //not the leaf
-            t->element_ = this->findMin(t->rightChild_)->element_; //lift the minimum element(leaf) from its rightChild
-            return erase(t->element_, t->rightChild_); //erase the leaf
-        } else { //one of its child is nullptr
-            t = std::move((t->leftChild_ != nullptr) ? t->leftChild_ : t->rightChild_);
+    auto link {&t};
+    while (*link != nullptr && !((*link)->element_ == theElement))
+        link = (theElement < (*link)->element_) ? &(*link)->leftChild_ : &(*link)->rightChild_;
+    if (*link == nullptr)
+        return false;
+    if ((*link)->leftChild_ != nullptr && (*link)->rightChild_ != nullptr) { //not the leaf
+        auto& min {findMin((*link)->rightChild_)}; //lift the minimum element from its rightChild
+        (*link)->element_ = std::move(min->element_);
+        link = &min; //and erase that node instead, it has no leftChild
+    }
+    auto parent {(*link)->parent_};
+    replaceWithChild(*link);
+    updatePath(parent, nullptr);
+    return true;
+}
+
+/*
+ *	depth-first walks without recursion: the nodes still to come back to are kept in stack,
+ *	so a degenerate tree costs heap memory instead of overflowing the call stack
+ *	(Morris threading would need no stack, but it relinks the tree while walking, so const walks could not share it,
+ *	and climbing through the parent links instead measured about 3x slower on a large scattered tree)
+ *	Node is node or const node, the links are read as Node* so a const walk stays const
+ */
+template <typename T, typename Alloc, typename Augment>
+template <typename Node, typename Visit>
+bool linkedBinaryTree<T, Alloc, Augment>::preOrder_(Node* t, Visit& theVisit, vector<Node*>& stack)
+{
+    stack.clear();
+    while (t != nullptr) {
+        if (!visitNode(theVisit, *t))
+            return false;
+        if (t->rightChild_ != nullptr)
+            stack.push_back(t->rightChild_.get());
+        if (t->leftChild_ != nullptr)
+            t = t->leftChild_.get();
+        else if (!stack.empty()) {
+            t = stack.back();
+            stack.pop_back();
+        } else
+            t = nullptr;
+    }
+    return true;
+}
+
+template <typename T, typename Alloc, typename Augment>
+template <typename Node, typename Visit>
+bool linkedBinaryTree<T, Alloc, Augment>::inOrder_(Node* t, Visit& theVisit, vector<Node*>& stack)
+{
+    stack.clear();
+    for (;;) {
+        for (; t != nullptr; t = t->leftChild_.get())
+            stack.push_back(t);
+        if (stack.empty())
             return true;
+        t = stack.back();
+        stack.pop_back();
+        if (!visitNode(theVisit, *t))
+            return false;
+        t = t->rightChild_.get();
+    }
+}
+
+//a node on the top of stack is visited once its rightChild is done, that is, right after the rightChild itself
+template <typename T, typename Alloc, typename Augment>
+template <typename Node, typename Visit>
+bool linkedBinaryTree<T, Alloc, Augment>::postOrder_(Node* t, Visit& theVisit, vector<Node*>& stack)
+{
+    stack.clear();
+    Node* last {nullptr}; //the node visited last
+    for (;;) {
+        for (; t != nullptr; t = t->leftChild_.get())
+            stack.push_back(t);
+        if (stack.empty())
+            return true;
+        Node* top {stack.back()};
+        if (top->rightChild_ != nullptr && top->rightChild_.get() != last)
+            t = top->rightChild_.get();
+        else {
+            if (!visitNode(theVisit, *top))
+                return false;
+            last = top;
+            stack.pop_back();
         }
     }
 }
 
-template <typename T>
-void linkedBinaryTree<T>::preOrder_(nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+const binaryTreeNode<T, Alloc, Augment>* linkedBinaryTree<T, Alloc, Augment>::first_(const node* t) noexcept
 {
-    if (t != nullptr) {
-        linkedBinaryTree<T>::visit_(t);
-        preOrder_(t->leftChild_);
-        preOrder_(t->rightChild_);
+    if (t != nullptr)
+        while (t->leftChild_ != nullptr)
+            t = t->leftChild_.get();
+    return t;
+}
+
+template <typename T, typename Alloc, typename Augment>
+const binaryTreeNode<T, Alloc, Augment>* linkedBinaryTree<T, Alloc, Augment>::last_(const node* t) noexcept
+{
+    if (t != nullptr)
+        while (t->rightChild_ != nullptr)
+            t = t->rightChild_.get();
+    return t;
+}
+
+//in-order successor: the minimum of the right subtree, or the first ancestor reached from its left
+template <typename T, typename Alloc, typename Augment>
+const binaryTreeNode<T, Alloc, Augment>* linkedBinaryTree<T, Alloc, Augment>::next_(const node* t) noexcept
+{
+    if (t->rightChild_ != nullptr)
+        return first_(t->rightChild_.get());
+    while (t->parent_ != nullptr && t->parent_->rightChild_.get() == t)
+        t = t->parent_;
+    return t->parent_;
+}
+
+template <typename T, typename Alloc, typename Augment>
+const binaryTreeNode<T, Alloc, Augment>* linkedBinaryTree<T, Alloc, Augment>::prev_(const node* t) noexcept
+{
+    if (t->leftChild_ != nullptr)
+        return last_(t->leftChild_.get());
+    while (t->parent_ != nullptr && t->parent_->leftChild_.get() == t)
+        t = t->parent_;
+    return t->parent_;
+}
+
+template <typename T, typename Alloc, typename Augment>
+template <typename K>
+typename linkedBinaryTree<T, Alloc, Augment>::iterator linkedBinaryTree<T, Alloc, Augment>::lowerBound_(const K& theKey) const noexcept
+{
+    const node* candidate {nullptr};
+    for (auto t = root_.get(); t != nullptr; ) {
+        if (t->element_ < theKey)
+            t = t->rightChild_.get();
+        else {
+            candidate = t;
+            t = t->leftChild_.get();
+        }
     }
-};
+    return iterator(candidate, this);
+}
 
-template <typename T>
-void linkedBinaryTree<T>::inOrder_(nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+template <typename K>
+typename linkedBinaryTree<T, Alloc, Augment>::iterator linkedBinaryTree<T, Alloc, Augment>::upperBound_(const K& theKey) const noexcept
 {
-    if (t != nullptr) {
-        inOrder_(t->leftChild_);
-        linkedBinaryTree<T>::visit_(t);
-        inOrder_(t->rightChild_);
+    const node* candidate {nullptr};
+    for (auto t = root_.get(); t != nullptr; ) {
+        if (theKey < t->element_) {
+            candidate = t;
+            t = t->leftChild_.get();
+        } else
+            t = t->rightChild_.get();
     }
+    return iterator(candidate, this);
 }
 
-template <typename T>
-void linkedBinaryTree<T>::postOrder_(nodePtr& t) noexcept
+template <typename T, typename Alloc, typename Augment>
+int linkedBinaryTree<T, Alloc, Augment>::rank(const T& theElement) const noexcept
 {
-    if (t != nullptr) {
-        postOrder_(t->leftChild_);
-        postOrder_(t->rightChild_);
-        linkedBinaryTree<T>::visit_(t);
-    }
-}
-
-//read method
-template <typename T>
-void linkedBinaryTree<T>::levelOrder_(const nodePtr& t) noexcept
-{
-    if (t) {
-        std::deque<nodePtr> queue;
-        //tmp use for move
-        auto tmp = std::make_unique<node>(t);
-        while (tmp != nullptr) {
-            visit_(tmp);
-            if (tmp->leftChild_ != nullptr)
-                queue.emplace_back(std::move(tmp->leftChild_));
-            if (tmp->rightChild_ != nullptr)
-                queue.emplace_back(std::move(tmp->rightChild_));
-            if (!queue.empty()) {
-                tmp = std::move(queue.front());
-                queue.pop_front();
-            } else tmp = nullptr;
+    static_assert(sized_, "rank needs sizeAugment or summaryAugment");
+    int r {};
+    for (auto t = root_.get(); t != nullptr; ) {
+        if (t->element_ < theElement) {
+            r += size_(t->leftChild_) + 1; //the left subtree and t itself
+            t = t->rightChild_.get();
+        } else
+            t = t->leftChild_.get();
+    }
+    return r;
+}
+
+template <typename T, typename Alloc, typename Augment>
+typename linkedBinaryTree<T, Alloc, Augment>::iterator linkedBinaryTree<T, Alloc, Augment>::select(int k) const noexcept
+{
+    static_assert(sized_, "select needs sizeAugment or summaryAugment");
+    auto t {root_.get()};
+    while (t != nullptr) {
+        auto leftSize {size_(t->leftChild_)};
+        if (k < leftSize)
+            t = t->leftChild_.get();
+        else if (k == leftSize)
+            break;
+        else {
+            k -= leftSize + 1;
+            t = t->rightChild_.get();
         }
     }
+    return iterator(t, this);
 }
 
-template <typename T>
-vector<int> linkedBinaryTree<T>::levelInfo() noexcept
-{
-    //initialize levelInfo
-    levelInfo_.clear();
-    levelInfo_.resize(this->height());
-    std::fill(levelInfo_.begin(), levelInfo_.end(), 0);
-    //initialize queue
-    std::deque<std::pair<nodePtr, int>> queue;
-    //copyRoot use for move
-    auto copyRoot {std::make_unique<node>(root_)};
-    if (copyRoot != nullptr) {
-        queue.emplace_back(std::make_pair(std::move(copyRoot), 1));
-        while (!queue.empty()) {
-            auto tmpPtr {std::move(queue.front().first)};
-            auto levelNo {queue.front().second};//current node's level No.
-            ++levelInfo_[levelNo - 1];
-            queue.pop_front();
-            if (tmpPtr->leftChild_ != nullptr)
-                queue.emplace_back(std::make_pair(std::move(tmpPtr->leftChild_), levelNo + 1));
-            if (tmpPtr->rightChild_ != nullptr)
-                queue.emplace_back(std::make_pair(std::move(tmpPtr->rightChild_), levelNo + 1));
+/*
+ *	descend until the first node inside [lo, hi] (the top of the range),
+ *	then its left subtree contributes the elements >= lo and its right subtree the elements <= hi,
+ *	each of them in one more descent that takes whole subtree summaries
+ */
+template <typename T, typename Alloc, typename Augment>
+auto linkedBinaryTree<T, Alloc, Augment>::aggregate(const T& lo, const T& hi) const noexcept
+{
+    using monoid = typename Augment::monoid;
+    auto top {root_.get()};
+    while (top != nullptr && (top->element_ < lo || hi < top->element_))
+        top = (top->element_ < lo) ? top->rightChild_.get() : top->leftChild_.get();
+    auto s {monoid::identity()};
+    if (top == nullptr)
+        return s;
+    for (auto t = top->leftChild_.get(); t != nullptr; ) { //suffix >= lo, prepended
+        if (t->element_ < lo)
+            t = t->rightChild_.get();
+        else {
+            auto part {monoid::lift(t->element_)};
+            if (t->rightChild_ != nullptr)
+                part = monoid::combine(part, t->rightChild_->summary_);
+            s = monoid::combine(part, s);
+            t = t->leftChild_.get();
         }
     }
-    return levelInfo_;
+    s = monoid::combine(s, monoid::lift(top->element_));
+    for (auto t = top->rightChild_.get(); t != nullptr; ) { //prefix <= hi, appended
+        if (hi < t->element_)
+            t = t->leftChild_.get();
+        else {
+            if (t->leftChild_ != nullptr)
+                s = monoid::combine(s, t->leftChild_->summary_);
+            s = monoid::combine(s, monoid::lift(t->element_));
+            t = t->rightChild_.get();
+        }
+    }
+    return s;
+}
+
+/*
+ *	level order engine, every level-order walk goes through here
+ *	the queue holds node addresses in ring (no node is copied or moved),
+ *	the caller keeps ring, so a walk allocates nothing once ring is wide enough for the tree
+ */
+template <typename T, typename Alloc, typename Augment>
+template <typename Node, typename Visit>
+bool linkedBinaryTree<T, Alloc, Augment>::levelOrder_(Node* root, Visit& theVisit, vector<Node*>& ring)
+{
+    if (root == nullptr)
+        return true;
+    if (ring.empty())
+        ring.resize(16);
+    auto mask {ring.size() - 1}; //the size is always a power of two
+    decltype (mask) head {}; //pop from here
+    decltype (mask) tail {}; //push to here
+    auto push = [&ring, &mask, &head, &tail](Node* t)
+    {
+        if (tail - head == ring.size()) { //full, double it and unwrap the content
+            vector<Node*> larger(ring.size() << 1);
+            for (auto i = head; i != tail; ++i)
+                larger[i - head] = ring[i & mask];
+            tail -= head;
+            head = 0;
+            ring.swap(larger);
+            mask = ring.size() - 1;
+        }
+        ring[tail++ & mask] = t;
+    };
+    push(root);
+    for (int levelNo = 0; head != tail; ++levelNo) {
+        const auto levelSize {tail - head};
+        for (decltype (mask) levelPos = 0; levelPos != levelSize; ++levelPos) {
+            Node* t {ring[head++ & mask]};
+            bool goOn {};
+            if constexpr (std::is_invocable_v<Visit&, Node&, int, int>)
+                goOn = visitNode(theVisit, *t, levelNo, static_cast<int>(levelPos));
+            else
+                goOn = visitNode(theVisit, *t);
+            if (!goOn)
+                return false;
+            if (t->leftChild_ != nullptr)
+                push(t->leftChild_.get());
+            if (t->rightChild_ != nullptr)
+                push(t->rightChild_.get());
+        }
+    }
+    return true;
+}
+
+template <typename T, typename Alloc, typename Augment>
+vector<int> linkedBinaryTree<T, Alloc, Augment>::levelInfo() const
+{
+    vector<int> info;
+    info.reserve(static_cast<std::size_t>(height_(root_))); //a hint only, the levels the walk meets decide the size
+    levelOrder([&info](const node&, int levelNo, int) {
+        if (static_cast<std::size_t>(levelNo) == info.size())
+            info.push_back(0);
+        ++info[levelNo];
+    });
+    return info;
+}
+
+template <typename T, typename Alloc, typename Augment>
+int linkedBinaryTree<T, Alloc, Augment>::width() const
+{
+    auto info {levelInfo()};
+    return info.empty() ? 0 : *std::max_element(info.cbegin(), info.cend());
 }
 
 #endif // LINKEDBINARYTREE_HPP
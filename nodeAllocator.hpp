@@ -0,0 +1,181 @@
+#ifndef NODEALLOCATOR_HPP
+#define NODEALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+/*
+ *	node allocation policies for linkedBinaryTree and the trees derived from it
+ *	a policy provides:
+ *	  deleter<Node>         the deleter type stored in every child unique_ptr
+ *	  pool<Node>            the per-tree object that hands out nodes (make)
+ *	                        adopt(other) takes over the nodes of another pool, so they may move between trees,
+ *	                        moving a pool takes them over the same way
+ *	  releasesInBulk        true if dropping the pool frees every node at once
+ *	  threadSafe            true if nodes may be freed from several threads at once
+ */
+
+//plain new/delete for every node (the default)
+struct heapAllocator
+{
+    static constexpr bool releasesInBulk = false;
+    static constexpr bool threadSafe = true;
+
+    template <typename Node>
+    using deleter = std::default_delete<Node>;
+
+    template <typename Node>
+    class pool
+    {
+    public:
+        template <typename... Args>
+        std::unique_ptr<Node, deleter<Node>> make(Args&&... args)
+        {
+            return std::make_unique<Node>(std::forward<Args>(args)...);
+        }
+        void adopt(pool&) noexcept { } //every node is on the global heap already
+    };
+};
+
+/*
+ *	slab allocator: nodes are carved out of ChunkBytes-sized chunks aligned to ChunkBytes,
+ *	so the chunk (and the pool owning it) is found by masking the node address
+ *	and the deleter stays stateless (a child link is still one pointer)
+ *	erased nodes go onto a free list and are reused by the next make()
+ *
+ *	|owner|next| node | node | node | ... |
+ *	 header     slots (bump allocated, then recycled through the free list)
+ */
+template <std::size_t ChunkBytes = (std::size_t{1} << 16)>
+struct poolAllocator
+{
+    static_assert((ChunkBytes & (ChunkBytes - 1)) == 0, "ChunkBytes must be a power of two");
+
+    static constexpr bool releasesInBulk = true;
+    static constexpr bool threadSafe = false;
+
+    template <typename Node>
+    class pool;
+
+    template <typename Node>
+    struct deleter
+    {
+        void operator()(Node* p) const noexcept {pool<Node>::owner(p)->destroy(p);}
+    };
+
+    template <typename Node>
+    class pool
+    {
+        struct chunk
+        {
+            pool* owner_;
+            chunk* next_;
+        };
+        union slot
+        {
+            slot* next_;
+            alignas(Node) unsigned char storage_[sizeof(Node)];
+        };
+        static constexpr std::size_t firstSlot_ {(sizeof(chunk) + alignof(slot) - 1) / alignof(slot) * alignof(slot)};
+        static constexpr std::size_t slotCount_ {(ChunkBytes - firstSlot_) / sizeof(slot)};
+        static_assert(alignof(slot) <= ChunkBytes && slotCount_ > 0, "ChunkBytes is too small for one node");
+    public:
+        pool() = default;
+        pool(const pool&) = delete;
+        pool& operator=(const pool&) = delete;
+        //a move takes every chunk over like adopt, the nodes go along (their deleter finds the new owner)
+        pool(pool&& other) noexcept {adopt(other);}
+        pool& operator=(pool&& other) noexcept //every node of this must be gone already
+        {
+            if (&other != this) {
+                release();
+                adopt(other);
+            }
+            return *this;
+        }
+        ~pool() {release();}
+        template <typename... Args>
+        std::unique_ptr<Node, deleter<Node>> make(Args&&... args)
+        {
+            void* p {allocate()};
+            try {
+                return std::unique_ptr<Node, deleter<Node>>(::new (p) Node(std::forward<Args>(args)...));
+            } catch (...) {
+                push(static_cast<slot*>(p));
+                throw;
+            }
+        }
+        void destroy(Node* p) noexcept
+        {
+            p->~Node();
+            push(reinterpret_cast<slot*>(p));
+        }
+        //take over every chunk of other (its nodes now come back here), other is left empty
+        void adopt(pool& other) noexcept
+        {
+            if (&other == this)
+                return;
+            while (other.bump_ != other.end_) //the unused tail of its current chunk
+                push(other.bump_++);
+            while (other.free_ != nullptr) {
+                auto s {other.free_};
+                other.free_ = s->next_;
+                push(s);
+            }
+            while (other.chunks_ != nullptr) {
+                auto c {other.chunks_};
+                other.chunks_ = c->next_;
+                c->owner_ = this;
+                c->next_ = chunks_;
+                chunks_ = c;
+            }
+            other.bump_ = other.end_ = nullptr;
+        }
+        //hand every chunk back at once (live nodes are abandoned, their destructors are not run)
+        void release() noexcept
+        {
+            while (chunks_ != nullptr) {
+                auto next {chunks_->next_};
+                ::operator delete(static_cast<void*>(chunks_), std::align_val_t{ChunkBytes});
+                chunks_ = next;
+            }
+            free_ = nullptr;
+            bump_ = end_ = nullptr;
+        }
+        static pool* owner(const Node* p) noexcept
+        {
+            auto base {reinterpret_cast<std::uintptr_t>(p) & ~(std::uintptr_t{ChunkBytes} - 1)};
+            return reinterpret_cast<chunk*>(base)->owner_;
+        }
+    private:
+        chunk* chunks_ {nullptr};
+        slot* free_ {nullptr};
+        slot* bump_ {nullptr};
+        slot* end_ {nullptr};
+        void* allocate()
+        {
+            if (free_ != nullptr) {
+                auto p {free_};
+                free_ = p->next_;
+                return p;
+            }
+            if (bump_ == end_) {
+                auto raw {static_cast<unsigned char*>(::operator new(ChunkBytes, std::align_val_t{ChunkBytes}))};
+                chunks_ = ::new (raw) chunk{this, chunks_};
+                bump_ = reinterpret_cast<slot*>(raw + firstSlot_);
+                end_ = bump_ + slotCount_;
+            }
+            return bump_++;
+        }
+        void push(slot* s) noexcept
+        {
+            s->next_ = free_;
+            free_ = s;
+        }
+    };
+};
+
+#endif // NODEALLOCATOR_HPP
@@ -0,0 +1,99 @@
+#ifndef NODEAUGMENT_HPP
+#define NODEAUGMENT_HPP
+
+#include <algorithm>
+#include <limits>
+
+/*
+ *	per-node augmentation policies for linkedBinaryTree and the trees derived from it
+ *	a policy provides:
+ *	  data<T>      a base class of binaryTreeNode holding the extra fields
+ *	  pull(node)   recompute those fields of a node from its children (children must be up to date)
+ *	the trees call pull wherever they refresh the cached height, so every insert, erase and rotation keeps it right
+ */
+
+//nothing extra (the default), data is empty and costs no space
+struct noAugment
+{
+    template <typename T>
+    struct data { };
+
+    template <typename Node>
+    static void pull(Node&) noexcept { }
+};
+
+//subtree size: O(1) nodeCount, O(log n) rank and select
+struct sizeAugment
+{
+    template <typename T>
+    struct data
+    {
+        int size_ {1}; //node count of the subtree rooted here
+    };
+
+    template <typename Node>
+    static void pull(Node& t) noexcept
+    {
+        t.size_ = 1 + (t.leftChild_ == nullptr ? 0 : t.leftChild_->size_)
+                    + (t.rightChild_ == nullptr ? 0 : t.rightChild_->size_);
+    }
+};
+
+/*
+ *	subtree size plus a monoid summary of the subtree elements: O(log n) range aggregates as well
+ *	a Monoid provides value_type, identity(), lift(element) and an associative combine(a, b)
+ *	combine is always applied in key order, so it does not need to commute
+ */
+template <typename Monoid>
+struct summaryAugment
+{
+    using monoid = Monoid;
+
+    template <typename T>
+    struct data
+    {
+        int size_ {1};
+        typename Monoid::value_type summary_ {Monoid::identity()};
+    };
+
+    template <typename Node>
+    static void pull(Node& t) noexcept
+    {
+        sizeAugment::pull(t);
+        auto s {Monoid::lift(t.element_)};
+        if (t.leftChild_ != nullptr)
+            s = Monoid::combine(t.leftChild_->summary_, s);
+        if (t.rightChild_ != nullptr)
+            s = Monoid::combine(s, t.rightChild_->summary_);
+        t.summary_ = s;
+    }
+};
+
+template <typename T>
+struct sumMonoid
+{
+    using value_type = T;
+    static value_type identity() noexcept {return value_type();}
+    static value_type lift(const T& theElement) noexcept {return theElement;}
+    static value_type combine(const value_type& a, const value_type& b) noexcept {return a + b;}
+};
+
+template <typename T>
+struct minMonoid
+{
+    using value_type = T;
+    static value_type identity() noexcept {return std::numeric_limits<T>::max();}
+    static value_type lift(const T& theElement) noexcept {return theElement;}
+    static value_type combine(const value_type& a, const value_type& b) noexcept {return std::min(a, b);}
+};
+
+template <typename T>
+struct maxMonoid
+{
+    using value_type = T;
+    static value_type identity() noexcept {return std::numeric_limits<T>::lowest();}
+    static value_type lift(const T& theElement) noexcept {return theElement;}
+    static value_type combine(const value_type& a, const value_type& b) noexcept {return std::max(a, b);}
+};
+
+#endif // NODEAUGMENT_HPP
@@ -0,0 +1,355 @@
+#ifndef PERSISTENTAVLTREE_HPP
+#define PERSISTENTAVLTREE_HPP
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <iostream>
+#include <memory>
+#include <utility>
+#include "binaryTree.hpp"
+
+/*
+ *	node of persistentAvlTree
+ *	a node is never modified after it is built, so any number of versions can share it
+ */
+template <typename T>
+class persistentNode
+{
+public:
+    using nodePtr = std::shared_ptr<const persistentNode>;
+    T element_;
+    nodePtr leftChild_;
+    nodePtr rightChild_;
+    int height_ {1}; //height of the subtree rooted here (a leaf is 1)
+    //E is const T& or T, an rvalue is moved into the node
+    template <typename E>
+    persistentNode(E&& theElement, nodePtr left, nodePtr right)
+        : element_(std::forward<E>(theElement)), leftChild_(std::move(left)), rightChild_(std::move(right))
+    {
+        auto hl {leftChild_ == nullptr ? 0 : leftChild_->height_};
+        auto hr {rightChild_ == nullptr ? 0 : rightChild_->height_};
+        height_ = hl > hr ? ++hl : ++hr;
+    }
+};
+
+/*
+ *	persistent (path-copying) AVL tree
+ *	insert and erase rebuild only the nodes on the root-to-leaf path (plus the ones a rotation touches),
+ *	everything else is shared with the previous version
+ *	copying the tree is O(1): the copy is a snapshot that later updates of either side never change
+ */
+template <typename T>
+class persistentAvlTree : public binaryTree<persistentNode<T>>
+{
+    using node = persistentNode<T>;
+    using nodePtr = typename node::nodePtr;
+
+public:
+    persistentAvlTree() = default;
+    persistentAvlTree(const persistentAvlTree&) = default;
+    //a moved-from tree is empty, the count goes along with the nodes
+    persistentAvlTree(persistentAvlTree&& rhs) noexcept : root_(std::move(rhs.root_)), count_(std::exchange(rhs.count_, 0)) { }
+    persistentAvlTree& operator=(const persistentAvlTree&) = default;
+    persistentAvlTree& operator=(persistentAvlTree&& rhs) noexcept
+    {
+        if (this != &rhs) {
+            root_ = std::move(rhs.root_);
+            count_ = std::exchange(rhs.count_, 0);
+        }
+        return *this;
+    }
+    inline bool empty() const noexcept override {return root_ == nullptr;}
+    inline int height() noexcept override {return height_(root_);}
+    inline int nodeCount() noexcept override {return count_;}
+    inline int size() const noexcept {return count_;}
+    persistentAvlTree snapshot() const noexcept {return *this;}
+    inline const nodePtr& root() const noexcept {return root_;}
+    void clear() noexcept
+    {
+        root_ = nullptr;
+        count_ = 0;
+    }
+    bool find(const T& theElement) const noexcept {return find_(theElement);}
+    template <typename K> requires transparentKey<K, T>
+    bool find(const K& theKey) const noexcept {return find_(theKey);}
+    //insert copies an lvalue into the new leaf and moves an rvalue there, the nodes rebuilt above it copy their own
+    bool insert(const T& theElement) {return insertRoot_(theElement);}
+    bool insert(T&& theElement) {return insertRoot_(std::move(theElement));}
+    bool erase(const T&);
+    //replace the content with a height-balanced tree in O(n), [first, last) must be sorted and free of duplicates
+    template <typename ForwardIt>
+    void build(ForwardIt first, ForwardIt last);
+    void build(std::vector<T> elements); //sorts and removes duplicates first
+    std::vector<int> levelInfo() const;
+    int width() const; //node count of the widest level
+    //traversals, the visitor sees const node& (nodes are immutable), the protocol is the one of visitNode
+    template <typename Visit>
+    bool preOrder(Visit&& theVisit) const {return preOrder_(root_.get(), theVisit);}
+    template <typename Visit>
+    bool inOrder(Visit&& theVisit) const {return inOrder_(root_.get(), theVisit);}
+    template <typename Visit>
+    bool postOrder(Visit&& theVisit) const {return postOrder_(root_.get(), theVisit);}
+    template <typename Visit>
+    bool levelOrder(Visit&& theVisit) const {return levelOrder_(theVisit);}
+    friend std::istream& operator>> (std::istream& is, persistentAvlTree<T>& t) {
+        T theElement;
+        is >> theElement;
+        if (is)
+            t.insert(std::move(theElement));
+        return is;
+    }
+private:
+    nodePtr root_;
+    int count_ {};
+    static int height_(const nodePtr& t) noexcept {return t == nullptr ? 0 : t->height_;}
+    template <typename K>
+    bool find_(const K&) const noexcept;
+    template <typename E>
+    static nodePtr makeNode_(E&& theElement, nodePtr left, nodePtr right)
+    {
+        return std::make_shared<const node>(std::forward<E>(theElement), std::move(left), std::move(right));
+    }
+    template <typename E>
+    bool insertRoot_(E&&); //insert_ below root_, and count it
+    static nodePtr balance_(const T&, nodePtr, nodePtr);
+    template <typename E>
+    static nodePtr insert_(E&&, const nodePtr&, bool&);
+    static nodePtr erase_(const T&, const nodePtr&, bool&);
+    static nodePtr eraseMin_(const nodePtr&, const T*&);
+    template <typename ForwardIt>
+    static nodePtr build_(ForwardIt&, std::size_t);
+    template <typename Visit>
+    static bool preOrder_(const node*, Visit&);
+    template <typename Visit>
+    static bool inOrder_(const node*, Visit&);
+    template <typename Visit>
+    static bool postOrder_(const node*, Visit&);
+    template <typename Visit>
+    bool levelOrder_(Visit&) const;
+};
+
+template <typename T>
+template <typename K>
+bool persistentAvlTree<T>::find_(const K& theElement) const noexcept
+{
+    for (auto t = root_.get(); t != nullptr; ) {
+        if (theElement < t->element_)
+            t = t->leftChild_.get();
+        else if (t->element_ < theElement)
+            t = t->rightChild_.get();
+        else
+            return true;
+    }
+    return false;
+}
+
+template <typename T>
+template <typename E>
+bool persistentAvlTree<T>::insertRoot_(E&& theElement)
+{
+    bool inserted {};
+    root_ = insert_(std::forward<E>(theElement), root_, inserted);
+    count_ += inserted;
+    return inserted;
+}
+
+template <typename T>
+bool persistentAvlTree<T>::erase(const T& theElement)
+{
+    bool erased {};
+    root_ = erase_(theElement, root_, erased);
+    count_ -= erased;
+    return erased;
+}
+
+/*
+ *	build a new node over (left, right), rotating if their heights differ by 2
+ *	the rotations are the ones of avlTree, except that the nodes they move are rebuilt instead of relinked
+ *
+ *	single (left-left):                  double (left-right):
+ *	         k2              k1                   k3                 k2
+ *	        .  .            .  .                 .  .               .  .
+ *	      k1    Z   ==>   X     k2             k1    D    ==>     k1    k3
+ *	     .  .                  .  .           .  .               . .    . .
+ *	    X    Y                Y    Z         A    k2            A   B  C   D
+ *	                                             .  .
+ *	                                            B    C
+ */
+template <typename T>
+typename persistentNode<T>::nodePtr persistentAvlTree<T>::balance_(const T& theElement, nodePtr left, nodePtr right)
+{
+    if (height_(left) - height_(right) > 1) {
+        if (height_(left->leftChild_) >= height_(left->rightChild_)) //single
+            return makeNode_(left->element_, left->leftChild_, makeNode_(theElement, left->rightChild_, std::move(right)));
+        const auto& k2 {left->rightChild_}; //double
+        return makeNode_(k2->element_, makeNode_(left->element_, left->leftChild_, k2->leftChild_),
+                         makeNode_(theElement, k2->rightChild_, std::move(right)));
+    }
+    if (height_(right) - height_(left) > 1) {
+        if (height_(right->rightChild_) >= height_(right->leftChild_)) //single
+            return makeNode_(right->element_, makeNode_(theElement, std::move(left), right->leftChild_), right->rightChild_);
+        const auto& k2 {right->leftChild_}; //double
+        return makeNode_(k2->element_, makeNode_(theElement, std::move(left), k2->leftChild_),
+                         makeNode_(right->element_, k2->rightChild_, right->rightChild_));
+    }
+    return makeNode_(theElement, std::move(left), std::move(right));
+}
+
+//E is const T& or T, the element is compared on the way down and moved into the leaf, which is its last use
+template <typename T>
+template <typename E>
+typename persistentNode<T>::nodePtr persistentAvlTree<T>::insert_(E&& theElement, const nodePtr& t, bool& inserted)
+{
+    if (t == nullptr) {
+        inserted = true;
+        return makeNode_(std::forward<E>(theElement), nullptr, nullptr);
+    }
+    if (theElement < t->element_) {
+        auto left {insert_(std::forward<E>(theElement), t->leftChild_, inserted)};
+        return inserted ? balance_(t->element_, std::move(left), t->rightChild_) : t;
+    }
+    if (t->element_ < theElement) {
+        auto right {insert_(std::forward<E>(theElement), t->rightChild_, inserted)};
+        return inserted ? balance_(t->element_, t->leftChild_, std::move(right)) : t;
+    }
+    return t; //the element was in the tree already, share the whole subtree
+}
+
+//remove the minimum of t, min points at its element afterwards (the old node stays alive in the old version)
+template <typename T>
+typename persistentNode<T>::nodePtr persistentAvlTree<T>::eraseMin_(const nodePtr& t, const T*& min)
+{
+    if (t->leftChild_ == nullptr) {
+        min = &t->element_;
+        return t->rightChild_;
+    }
+    return balance_(t->element_, eraseMin_(t->leftChild_, min), t->rightChild_);
+}
+
+template <typename T>
+typename persistentNode<T>::nodePtr persistentAvlTree<T>::erase_(const T& theElement, const nodePtr& t, bool& erased)
+{
+    if (t == nullptr)
+        return nullptr;
+    if (theElement < t->element_) {
+        auto left {erase_(theElement, t->leftChild_, erased)};
+        return erased ? balance_(t->element_, std::move(left), t->rightChild_) : t;
+    }
+    if (t->element_ < theElement) {
+        auto right {erase_(theElement, t->rightChild_, erased)};
+        return erased ? balance_(t->element_, t->leftChild_, std::move(right)) : t;
+    }
+    erased = true;
+    if (t->leftChild_ == nullptr)
+        return t->rightChild_;
+    if (t->rightChild_ == nullptr)
+        return t->leftChild_;
+    const T* min {nullptr};
+    auto right {eraseMin_(t->rightChild_, min)}; //lift the minimum element of the rightChild
+    return balance_(*min, t->leftChild_, std::move(right));
+}
+
+template <typename T>
+template <typename ForwardIt>
+void persistentAvlTree<T>::build(ForwardIt first, ForwardIt last)
+{
+    auto n {static_cast<std::size_t>(std::distance(first, last))};
+    root_ = build_(first, n);
+    count_ = static_cast<int>(n);
+}
+
+template <typename T>
+void persistentAvlTree<T>::build(std::vector<T> elements)
+{
+    std::sort(elements.begin(), elements.end());
+    elements.erase(std::unique(elements.begin(), elements.end()), elements.end());
+    build(elements.cbegin(), elements.cend());
+}
+
+template <typename T>
+template <typename ForwardIt>
+typename persistentNode<T>::nodePtr persistentAvlTree<T>::build_(ForwardIt& it, std::size_t n)
+{
+    if (n == 0)
+        return nullptr;
+    auto left {build_(it, n / 2)};
+    const auto& theElement {*it};
+    ++it;
+    auto right {build_(it, n - n / 2 - 1)};
+    return makeNode_(theElement, std::move(left), std::move(right));
+}
+
+template <typename T>
+template <typename Visit>
+bool persistentAvlTree<T>::preOrder_(const node* t, Visit& theVisit)
+{
+    if (t == nullptr)
+        return true;
+    return visitNode(theVisit, *t) && preOrder_(t->leftChild_.get(), theVisit) && preOrder_(t->rightChild_.get(), theVisit);
+}
+
+template <typename T>
+template <typename Visit>
+bool persistentAvlTree<T>::inOrder_(const node* t, Visit& theVisit)
+{
+    if (t == nullptr)
+        return true;
+    return inOrder_(t->leftChild_.get(), theVisit) && visitNode(theVisit, *t) && inOrder_(t->rightChild_.get(), theVisit);
+}
+
+template <typename T>
+template <typename Visit>
+bool persistentAvlTree<T>::postOrder_(const node* t, Visit& theVisit)
+{
+    if (t == nullptr)
+        return true;
+    return postOrder_(t->leftChild_.get(), theVisit) && postOrder_(t->rightChild_.get(), theVisit) && visitNode(theVisit, *t);
+}
+
+//level by level, the next level is collected while the current one is visited
+template <typename T>
+template <typename Visit>
+bool persistentAvlTree<T>::levelOrder_(Visit& theVisit) const
+{
+    std::vector<const node*> level;
+    std::vector<const node*> lower;
+    if (root_ != nullptr)
+        level.emplace_back(root_.get());
+    for (int levelNo = 0; !level.empty(); ++levelNo) {
+        lower.clear();
+        for (std::size_t levelPos = 0; levelPos != level.size(); ++levelPos) {
+            const node* t {level[levelPos]};
+            bool goOn {};
+            if constexpr (std::is_invocable_v<Visit&, const node&, int, int>)
+                goOn = visitNode(theVisit, *t, levelNo, static_cast<int>(levelPos));
+            else
+                goOn = visitNode(theVisit, *t);
+            if (!goOn)
+                return false;
+            if (t->leftChild_ != nullptr)
+                lower.emplace_back(t->leftChild_.get());
+            if (t->rightChild_ != nullptr)
+                lower.emplace_back(t->rightChild_.get());
+        }
+        level.swap(lower);
+    }
+    return true;
+}
+
+template <typename T>
+std::vector<int> persistentAvlTree<T>::levelInfo() const
+{
+    std::vector<int> info(height_(root_), 0);
+    levelOrder([&info](const node&, int levelNo, int) {++info[levelNo];});
+    return info;
+}
+
+template <typename T>
+int persistentAvlTree<T>::width() const
+{
+    auto info {levelInfo()};
+    return info.empty() ? 0 : *std::max_element(info.cbegin(), info.cend());
+}
+
+#endif // PERSISTENTAVLTREE_HPP
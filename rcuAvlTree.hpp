@@ -0,0 +1,106 @@
+#ifndef RCUAVLTREE_HPP
+#define RCUAVLTREE_HPP
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include "binaryTree.hpp"
+#include "epochReclaimer.hpp"
+#include "persistentAvlTree.hpp"
+
+/*
+ *	AVL tree for many readers and one writer (read-copy-update)
+ *	the writer changes a copy of the current persistentAvlTree, which rebuilds only the path it changes,
+ *	and publishes the new version with one atomic store of a pointer
+ *	a reader pins an epoch, loads that pointer and walks the immutable nodes with plain loads:
+ *	no lock, no read-modify-write and no reference count on the way, so readers never wait and never
+ *	write a shared cache line
+ *	a replaced version goes to epochReclaimer, its nodes (those no later version shares) are freed
+ *	once every reader that could have loaded it has unpinned
+ *
+ *	  rcuAvlTree<int> t;
+ *	  t.insert(1);                             //the writer
+ *	  t.find(1);                               //any thread
+ *	  auto r {t.read()};                       //one consistent version for a series of reads
+ *	  r->inOrder([](const auto& p) {...});
+ *	  t.update([](auto& v) {v.insert(2); v.erase(1);});    //several changes, published at once
+ *
+ *	writers are serialized by a mutex: more writer threads are correct, but they do not scale
+ */
+template <typename T>
+class rcuAvlTree : public binaryTree<persistentNode<T>>
+{
+public:
+    using version = persistentAvlTree<T>;
+    //a pinned version, it stays valid and unchanged while the reader lives
+    class reader
+    {
+    public:
+        explicit reader(const rcuAvlTree& theTree) noexcept
+            : version_(theTree.published_.load(std::memory_order_acquire)) { }
+        reader(const reader&) = delete;
+        reader& operator=(const reader&) = delete;
+        inline const version& operator*() const noexcept {return *version_;}
+        inline const version* operator->() const noexcept {return version_;}
+    private:
+        epochReclaimer::guard pin_; //declared first: pinned before the version is loaded
+        const version* version_;
+    };
+    rcuAvlTree() : published_(new version) { }
+    rcuAvlTree(const rcuAvlTree&) = delete;
+    rcuAvlTree& operator=(const rcuAvlTree&) = delete;
+    ~rcuAvlTree() {delete published_.load();} //no reader may be left
+    //readers, any thread
+    inline reader read() const noexcept {return reader(*this);}
+    inline bool empty() const noexcept override {return read()->empty();}
+    inline int height() noexcept override
+    {
+        auto r {read()};
+        return r->root() == nullptr ? 0 : r->root()->height_;
+    }
+    inline int nodeCount() noexcept override {return read()->size();}
+    inline bool find(const T& theElement) const noexcept {return read()->find(theElement);}
+    template <typename K> requires transparentKey<K, T>
+    bool find(const K& theKey) const noexcept {return read()->find(theKey);}
+    //writers
+    bool insert(const T& theElement) {return update([&theElement](version& v) {return v.insert(theElement);});}
+    bool insert(T&& theElement) {return update([&theElement](version& v) {return v.insert(std::move(theElement));});}
+    bool erase(const T& theElement) {return update([&theElement](version& v) {return v.erase(theElement);});}
+    //theChange(version&) edits the next version, which is published unless it is left unchanged, its result is returned
+    template <typename Change>
+    auto update(Change&& theChange);
+private:
+    std::atomic<version*> published_;
+    std::mutex writeMutex_;
+};
+
+template <typename T>
+template <typename Change>
+auto rcuAvlTree<T>::update(Change&& theChange)
+{
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto current {published_.load(std::memory_order_relaxed)};
+    auto next {std::make_unique<version>(*current)}; //O(1), shares every node
+    auto publish = [this, current, &next]
+    {
+        if (next->root() == current->root())
+            return;
+        /*
+         *	seq_cst: a reader whose pin comes after this store in the single order also loads the new version,
+         *	so every reader of current was pinned no later than the epoch current is retired with
+         */
+        published_.store(next.release());
+        epochReclaimer::instance().retire(current);
+    };
+    if constexpr (std::is_void_v<std::invoke_result_t<Change&, version&>>) {
+        theChange(*next);
+        publish();
+    } else {
+        auto r {theChange(*next)};
+        publish();
+        return r;
+    }
+}
+
+#endif // RCUAVLTREE_HPP
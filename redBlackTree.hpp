@@ -0,0 +1,237 @@
+#ifndef REDBLACKTREE_HPP
+#define REDBLACKTREE_HPP
+
+#include "linkedBinaryTree.hpp"
+
+/*
+ *	red-black tree: no red node has a red child, and every path from a node down to a missing child
+ *	passes the same number of black nodes, so the height is at most 2 log(n + 1)
+ *	looser than AVL, which buys cheaper updates: insert rotates at most twice and erase at most three times,
+ *	the rest of the repair is recoloring (see avlTree for the strict balance and the faster searches)
+ *	the color is the red_ flag of binaryTreeNode, the cached heights are kept too (height(), levelInfo and
+ *	the drawing read them), by updatePath, which stops as soon as a height does not change
+ *	insert and erase work on the parent links without recursion, the tree handed in is taken as the whole tree
+ */
+template <typename T, typename Alloc = heapAllocator, typename Augment = noAugment>
+class redBlackTree : public linkedBinaryTree<T, Alloc, Augment>
+{
+    using base = linkedBinaryTree<T, Alloc, Augment>;
+    using node = binaryTreeNode<T, Alloc, Augment>;
+    using nodePtr = typename node::nodePtr;
+public:
+    nodePtr& insert(const T& theElement, nodePtr& t) noexcept override {return insert_(theElement, t);}
+    nodePtr& insert(T&& theElement, nodePtr& t) noexcept override {return insert_(std::move(theElement), t);}
+    bool erase(const T&, nodePtr&) noexcept override;
+    //a snapshot carries no colors, so the keys are always rebuilt balanced (and colored by afterBuild_)
+    bool loadSnapshot(const std::string& path, bool = true) override {return base::loadSnapshot(path, false);}
+    //the root is black, no red node has a red child, and every path down passes the same number of black nodes
+    bool valid() const noexcept {return !red_(this->root()) && blackHeight_(this->root().get()) >= 0;}
+    friend std::istream& operator>> (std::istream& is, redBlackTree<T, Alloc, Augment>& t) {
+        T theElement;
+        is >> theElement;
+        if (is)
+            t.insert(std::move(theElement), t.root());
+        return is;
+    }
+protected:
+    //build and loadSnapshot make the balanced tree of linkedBinaryTree: its last level red, every other node black
+    void afterBuild_() noexcept override {colorLastLevel_();}
+private:
+    static bool red_(const node* t) noexcept {return t != nullptr && t->red_;} //a missing child is black
+    static bool red_(const nodePtr& t) noexcept {return red_(t.get());}
+    //the link that owns x: root itself, or the child link of the parent of x
+    static nodePtr& link_(node* x, nodePtr& root) noexcept
+    {
+        if (x == root.get())
+            return root;
+        return x == x->parent_->leftChild_.get() ? x->parent_->leftChild_ : x->parent_->rightChild_;
+    }
+    template <typename E>
+    nodePtr& insert_(E&&, nodePtr&) noexcept;
+    node* rotateLeft_(node*, nodePtr&) noexcept;
+    node* rotateRight_(node*, nodePtr&) noexcept;
+    void colorLastLevel_() noexcept;
+    //the black nodes on every path down from t, -1 if the rules are broken below t (at most 2 log n deep)
+    static int blackHeight_(const node* t) noexcept
+    {
+        if (t == nullptr)
+            return 0;
+        if (t->red_ && (red_(t->leftChild_) || red_(t->rightChild_)))
+            return -1;
+        auto l {blackHeight_(t->leftChild_.get())};
+        if (l < 0 || l != blackHeight_(t->rightChild_.get()))
+            return -1;
+        return l + (t->red_ ? 0 : 1);
+    }
+};
+
+/*
+ *	the rotations of avlTree, on the parent links: x goes down, its child y comes up into the link of x
+ *	the heights of x and y are recomputed, and the ones above if the subtree got higher or lower
+ *
+ *	     x                 y
+ *	    .  .              .  .
+ *	   A    y    ==>     x    C
+ *	       .  .         .  .
+ *	      B    C       A    B
+ */
+template <typename T, typename Alloc, typename Augment>
+typename redBlackTree<T, Alloc, Augment>::node* redBlackTree<T, Alloc, Augment>::rotateLeft_(node* x, nodePtr& root) noexcept
+{
+    auto& link {link_(x, root)};
+    auto old {x->height_};
+    auto y {std::move(x->rightChild_)};
+    x->rightChild_ = std::move(y->leftChild_);
+    if (x->rightChild_ != nullptr)
+        x->rightChild_->parent_ = x;
+    y->parent_ = x->parent_;
+    x->parent_ = y.get();
+    y->leftChild_ = std::move(link);
+    this->updateNode(x);
+    this->updateNode(y);
+    link = std::move(y);
+    if (link->height_ != old) //the same elements below, so only the heights above can change
+        this->updatePath(link->parent_, nullptr);
+    return link.get();
+}
+
+template <typename T, typename Alloc, typename Augment>
+typename redBlackTree<T, Alloc, Augment>::node* redBlackTree<T, Alloc, Augment>::rotateRight_(node* x, nodePtr& root) noexcept
+{
+    auto& link {link_(x, root)};
+    auto old {x->height_};
+    auto y {std::move(x->leftChild_)};
+    x->leftChild_ = std::move(y->rightChild_);
+    if (x->leftChild_ != nullptr)
+        x->leftChild_->parent_ = x;
+    y->parent_ = x->parent_;
+    x->parent_ = y.get();
+    y->rightChild_ = std::move(link);
+    this->updateNode(x);
+    this->updateNode(y);
+    link = std::move(y);
+    if (link->height_ != old) //the same elements below, so only the heights above can change
+        this->updatePath(link->parent_, nullptr);
+    return link.get();
+}
+
+/*
+ *	the new node is red, so only "red under red" can be wrong, at z and its parent p:
+ *	a red uncle u: p and u turn black, the grandparent g red, and the problem moves up to g
+ *	a black uncle: one or two rotations put p (or z) over g, which ends it
+ *	E is const T& or T, an rvalue is moved into the new node
+ */
+template <typename T, typename Alloc, typename Augment>
+template <typename E>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& redBlackTree<T, Alloc, Augment>::insert_(E&& theElement, nodePtr& t) noexcept
+{
+    auto link {&t};
+    node* parent {t == nullptr ? nullptr : t->parent_};
+    while (*link != nullptr) {
+        parent = link->get();
+        if (theElement < parent->element_)
+            link = &parent->leftChild_;
+        else if (parent->element_ < theElement)
+            link = &parent->rightChild_;
+        else
+            return t; //the element was in the tree already
+    }
+    *link = this->makeNode(std::forward<E>(theElement));
+    node* z {link->get()};
+    z->parent_ = parent;
+    z->red_ = true;
+    this->updatePath(parent, nullptr); //up to the real root, t may be a subtree link
+    while (z != t.get() && red_(z->parent_)) {
+        auto p {z->parent_};
+        auto g {p->parent_}; //p is red, so it is not the root
+        bool left {p == g->leftChild_.get()};
+        auto u {left ? g->rightChild_.get() : g->leftChild_.get()};
+        if (red_(u)) {
+            p->red_ = false;
+            u->red_ = false;
+            g->red_ = true;
+            z = g;
+            continue;
+        }
+        if (z == (left ? p->rightChild_.get() : p->leftChild_.get())) //inner grandchild: turn it outer first
+            p = left ? rotateLeft_(p, t) : rotateRight_(p, t);
+        p->red_ = false;
+        g->red_ = true;
+        left ? rotateRight_(g, t) : rotateLeft_(g, t);
+        break;
+    }
+    t->red_ = false;
+    return t;
+}
+
+/*
+ *	a node with two children takes the element of its successor, which is erased instead (as in linkedBinaryTree)
+ *	the erased node y has at most one child x, which moves up; if y was black, the paths through x
+ *	lack one black: x "carries an extra black" up the tree until it meets a red node (which turns black)
+ *	or a rotation at its sibling w gives the black back
+ */
+template <typename T, typename Alloc, typename Augment>
+bool redBlackTree<T, Alloc, Augment>::erase(const T& theElement, nodePtr& t) noexcept
+{
+    if (t == nullptr)
+        return false;
+    auto link {&t};
+    while (*link != nullptr && !((*link)->element_ == theElement))
+        link = (theElement < (*link)->element_) ? &(*link)->leftChild_ : &(*link)->rightChild_;
+    if (*link == nullptr)
+        return false;
+    if ((*link)->leftChild_ != nullptr && (*link)->rightChild_ != nullptr) {
+        auto& min {this->findMin((*link)->rightChild_)};
+        (*link)->element_ = std::move(min->element_); //that node goes next, its element is not read again
+        link = &min;
+    }
+    bool black {!(*link)->red_};
+    auto xp {(*link)->parent_};
+    this->replaceWithChild(*link);
+    node* x {link->get()};
+    this->updatePath(xp, nullptr);
+    if (!black) //a red node is never the root, and the black counts did not change
+        return true;
+    while (x != t.get() && !red_(x)) {
+        bool left {x == xp->leftChild_.get()};
+        auto w {left ? xp->rightChild_.get() : xp->leftChild_.get()}; //not nullptr, its side holds a black more
+        if (w->red_) { //make the sibling black: rotate the red one over xp
+            w->red_ = false;
+            xp->red_ = true;
+            left ? rotateLeft_(xp, t) : rotateRight_(xp, t);
+            w = left ? xp->rightChild_.get() : xp->leftChild_.get();
+        }
+        auto outer {left ? w->rightChild_.get() : w->leftChild_.get()};
+        auto inner {left ? w->leftChild_.get() : w->rightChild_.get()};
+        if (!red_(outer) && !red_(inner)) { //w can turn red, the extra black moves up to xp
+            w->red_ = true;
+            x = xp;
+            xp = x->parent_;
+            continue;
+        }
+        if (!red_(outer)) { //the red inner child comes up in place of w
+            inner->red_ = false;
+            w->red_ = true;
+            w = left ? rotateRight_(w, t) : rotateLeft_(w, t);
+            outer = left ? w->rightChild_.get() : w->leftChild_.get();
+        }
+        w->red_ = xp->red_;
+        xp->red_ = false;
+        outer->red_ = false;
+        left ? rotateLeft_(xp, t) : rotateRight_(xp, t);
+        x = t.get();
+    }
+    if (x != nullptr)
+        x->red_ = false;
+    return true;
+}
+
+//the build of linkedBinaryTree leaves every missing child on the last two levels: black above, red on the last
+template <typename T, typename Alloc, typename Augment>
+void redBlackTree<T, Alloc, Augment>::colorLastLevel_() noexcept
+{
+    auto last {this->height() - 1};
+    this->levelOrder([last](node& p, int levelNo, int) {p.red_ = levelNo == last && last != 0;});
+}
+
+#endif // REDBLACKTREE_HPP
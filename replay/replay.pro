@@ -0,0 +1,13 @@
+# replay an operation log against the trees, no Qt modules needed
+# qmake replay.pro && make && ./treeReplay --tree avl --report json ops.log
+
+TEMPLATE = app
+TARGET = treeReplay
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+include(../treeCore.pri)
+
+SOURCES += \
+    treeReplay.cpp
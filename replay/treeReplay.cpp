@@ -0,0 +1,282 @@
+#include "avlTree.hpp"
+#include "linkedBinaryTree.hpp"
+#include "redBlackTree.hpp"
+#include "splayTree.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ *	replay a recorded operation log against one of the trees and report throughput and latency
+ *
+ *	text log, one operation per line (blank lines and lines starting with # are skipped):
+ *	  insert 42
+ *	  erase 42
+ *	  find 42
+ *	binary log: the 8 bytes "TREELOG1", then 5 bytes per operation:
+ *	  op (0 insert, 1 erase, 2 find), key (int32, little endian)
+ *	every operation is timed on its own, the overall ops/s includes those clock reads
+ *
+ *	usage: treeReplay [--tree avl|avl-pool|rb|splay|linked] [--report text|json] [--save-binary file] log
+ */
+
+namespace {
+
+using clockType = std::chrono::steady_clock;
+
+enum class opCode : std::uint8_t {insert = 0, erase = 1, find = 2};
+constexpr const char* opNames[] {"insert", "erase", "find"};
+constexpr char binaryMagic[8] {'T', 'R', 'E', 'E', 'L', 'O', 'G', '1'};
+
+struct operation
+{
+    opCode op;
+    int key;
+};
+
+struct options
+{
+    std::string tree {"avl"};
+    std::string report {"text"};
+    std::string saveBinary;
+    std::string log;
+};
+
+bool readText(std::istream& is, std::vector<operation>& ops, std::string& error)
+{
+    std::string line;
+    for (int lineNo = 1; std::getline(is, line); ++lineNo) {
+        std::istringstream ls(line);
+        std::string name;
+        if (!(ls >> name) || name[0] == '#')
+            continue;
+        long long key {};
+        auto op {std::find(std::begin(opNames), std::end(opNames), name)};
+        if (op == std::end(opNames) || !(ls >> key) || key < INT32_MIN || key > INT32_MAX) {
+            error = "line " + std::to_string(lineNo) + ": expected insert|erase|find <int>";
+            return false;
+        }
+        ops.push_back({static_cast<opCode>(op - std::begin(opNames)), static_cast<int>(key)});
+    }
+    return true;
+}
+
+bool readBinary(std::istream& is, std::vector<operation>& ops, std::string& error)
+{
+    unsigned char record[5];
+    while (is.read(reinterpret_cast<char*>(record), sizeof(record))) {
+        if (record[0] > static_cast<unsigned char>(opCode::find)) {
+            error = "record " + std::to_string(ops.size()) + ": unknown op " + std::to_string(record[0]);
+            return false;
+        }
+        auto key {static_cast<std::uint32_t>(record[1]) | static_cast<std::uint32_t>(record[2]) << 8
+                  | static_cast<std::uint32_t>(record[3]) << 16 | static_cast<std::uint32_t>(record[4]) << 24};
+        ops.push_back({static_cast<opCode>(record[0]), static_cast<int>(key)});
+    }
+    if (is.gcount() != 0) {
+        error = "truncated record at the end of the log";
+        return false;
+    }
+    return true;
+}
+
+bool readLog(const std::string& path, std::vector<operation>& ops, std::string& error)
+{
+    std::ifstream is(path, std::ios::binary);
+    if (!is) {
+        error = "cannot open " + path;
+        return false;
+    }
+    char magic[sizeof(binaryMagic)] {};
+    is.read(magic, sizeof(magic));
+    if (is.gcount() == sizeof(magic) && std::memcmp(magic, binaryMagic, sizeof(magic)) == 0)
+        return readBinary(is, ops, error);
+    is.clear();
+    is.seekg(0);
+    return readText(is, ops, error);
+}
+
+bool writeBinary(const std::string& path, const std::vector<operation>& ops)
+{
+    std::ofstream os(path, std::ios::binary);
+    os.write(binaryMagic, sizeof(binaryMagic));
+    for (const auto& o : ops) {
+        auto key {static_cast<std::uint32_t>(o.key)};
+        const char record[5] {static_cast<char>(o.op), static_cast<char>(key & 0xff), static_cast<char>(key >> 8 & 0xff),
+                              static_cast<char>(key >> 16 & 0xff), static_cast<char>(key >> 24 & 0xff)};
+        os.write(record, sizeof(record));
+    }
+    return static_cast<bool>(os);
+}
+
+//latencies of one kind of operation, in nanoseconds
+struct latency
+{
+    std::vector<std::uint32_t> samples;
+    std::uint64_t totalNs {};
+    std::uint64_t hits {}; //inserted, erased or found
+    //the q-quantile (0 <= q <= 1), samples gets partially sorted
+    std::uint32_t quantile(double q)
+    {
+        if (samples.empty())
+            return 0;
+        auto k {static_cast<std::size_t>(q * static_cast<double>(samples.size() - 1))};
+        std::nth_element(samples.begin(), samples.begin() + k, samples.end());
+        return samples[k];
+    }
+    //counts per power-of-two bucket, bucket b holds [2^b, 2^(b+1)) ns
+    std::vector<std::uint64_t> histogram() const
+    {
+        std::vector<std::uint64_t> buckets;
+        for (auto s : samples) {
+            std::size_t b {};
+            while ((s >>= 1) != 0)
+                ++b;
+            if (b >= buckets.size())
+                buckets.resize(b + 1);
+            ++buckets[b];
+        }
+        return buckets;
+    }
+};
+
+//the tree is driven through its public interface only, the same way treePainter does
+template <typename Tree>
+void replay(const std::vector<operation>& ops, latency (&stats)[3], double& wallSeconds)
+{
+    Tree t;
+    for (auto& s : stats)
+        s.samples.reserve(ops.size() / 3);
+    auto wallStart {clockType::now()};
+    for (const auto& o : ops) {
+        bool hit {o.op == opCode::insert && !t.find(o.key)}; //insert does not tell, so ask before the clock starts
+        auto start {clockType::now()};
+        switch (o.op) {
+        case opCode::insert:
+            t.insert(o.key, t.root());
+            break;
+        case opCode::erase:
+            hit = t.erase(o.key, t.root());
+            break;
+        case opCode::find:
+            hit = t.find(o.key);
+            break;
+        }
+        auto ns {std::chrono::duration_cast<std::chrono::nanoseconds>(clockType::now() - start).count()};
+        auto& s {stats[static_cast<int>(o.op)]};
+        s.samples.push_back(static_cast<std::uint32_t>(std::min<long long>(ns, UINT32_MAX)));
+        s.totalNs += static_cast<std::uint64_t>(ns);
+        s.hits += hit;
+    }
+    wallSeconds = std::chrono::duration<double>(clockType::now() - wallStart).count();
+}
+
+void reportText(std::ostream& os, const options& opt, std::size_t opCount, latency (&stats)[3], double wallSeconds)
+{
+    os << "tree " << opt.tree << ", " << opCount << " operations in " << wallSeconds << " s, "
+       << static_cast<double>(opCount) / wallSeconds << " ops/s\n";
+    for (int i = 0; i != 3; ++i) {
+        auto& s {stats[i]};
+        if (s.samples.empty())
+            continue;
+        os << opNames[i] << ": " << s.samples.size() << " ops, " << s.hits << " hits, "
+           << static_cast<double>(s.samples.size()) * 1e9 / static_cast<double>(std::max<std::uint64_t>(s.totalNs, 1)) << " ops/s"
+           << ", p50 " << s.quantile(0.5) << " ns, p99 " << s.quantile(0.99) << " ns, p999 " << s.quantile(0.999)
+           << " ns, max " << s.quantile(1.0) << " ns\n";
+        auto buckets {s.histogram()};
+        for (std::size_t b = 0; b != buckets.size(); ++b)
+            if (buckets[b] != 0)
+                os << "  [" << (std::uint64_t{1} << b) << ", " << (std::uint64_t{1} << (b + 1)) << ") ns: " << buckets[b] << '\n';
+    }
+}
+
+void reportJson(std::ostream& os, const options& opt, std::size_t opCount, latency (&stats)[3], double wallSeconds)
+{
+    os << "{\n  \"tree\": \"" << opt.tree << "\",\n  \"operations\": " << opCount << ",\n  \"seconds\": " << wallSeconds
+       << ",\n  \"opsPerSecond\": " << static_cast<double>(opCount) / wallSeconds << ",\n  \"byOperation\": {";
+    bool first {true};
+    for (int i = 0; i != 3; ++i) {
+        auto& s {stats[i]};
+        if (s.samples.empty())
+            continue;
+        os << (first ? "\n" : ",\n") << "    \"" << opNames[i] << "\": {\"count\": " << s.samples.size()
+           << ", \"hits\": " << s.hits << ", \"p50Ns\": " << s.quantile(0.5) << ", \"p99Ns\": " << s.quantile(0.99)
+           << ", \"p999Ns\": " << s.quantile(0.999) << ", \"maxNs\": " << s.quantile(1.0) << ", \"log2Histogram\": [";
+        auto buckets {s.histogram()};
+        for (std::size_t b = 0; b != buckets.size(); ++b)
+            os << (b == 0 ? "" : ", ") << buckets[b];
+        os << "]}";
+        first = false;
+    }
+    os << "\n  }\n}\n";
+}
+
+bool parse(int argc, char* argv[], options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg {argv[i]};
+        if (arg.rfind("--", 0) != 0) {
+            if (!opt.log.empty())
+                return false;
+            opt.log = arg;
+            continue;
+        }
+        if (i + 1 == argc)
+            return false;
+        std::string value {argv[++i]};
+        if (arg == "--tree" && (value == "avl" || value == "avl-pool" || value == "rb" || value == "splay" || value == "linked"))
+            opt.tree = value;
+        else if (arg == "--report" && (value == "text" || value == "json"))
+            opt.report = value;
+        else if (arg == "--save-binary")
+            opt.saveBinary = value;
+        else
+            return false;
+    }
+    return !opt.log.empty();
+}
+
+} //namespace
+
+int main(int argc, char* argv[])
+{
+    options opt;
+    if (!parse(argc, argv, opt)) {
+        std::cerr << "usage: treeReplay [--tree avl|avl-pool|rb|splay|linked] [--report text|json] [--save-binary file] log\n";
+        return 2;
+    }
+    std::vector<operation> ops;
+    std::string error;
+    if (!readLog(opt.log, ops, error)) {
+        std::cerr << "treeReplay: " << error << '\n';
+        return 1;
+    }
+    if (!opt.saveBinary.empty() && !writeBinary(opt.saveBinary, ops)) {
+        std::cerr << "treeReplay: cannot write " << opt.saveBinary << '\n';
+        return 1;
+    }
+    latency stats[3];
+    double wallSeconds {};
+    if (opt.tree == "avl")
+        replay<avlTree<int>>(ops, stats, wallSeconds);
+    else if (opt.tree == "avl-pool")
+        replay<avlTree<int, poolAllocator<>>>(ops, stats, wallSeconds);
+    else if (opt.tree == "rb")
+        replay<redBlackTree<int>>(ops, stats, wallSeconds);
+    else if (opt.tree == "splay")
+        replay<splayTree<int>>(ops, stats, wallSeconds);
+    else
+        replay<linkedBinaryTree<int>>(ops, stats, wallSeconds);
+    if (opt.report == "json")
+        reportJson(std::cout, opt, ops.size(), stats, wallSeconds);
+    else
+        reportText(std::cout, opt, ops.size(), stats, wallSeconds);
+    return 0;
+}
@@ -1,74 +1,236 @@
 #ifndef SEQBINARYTREE_HPP
 #define SEQBINARYTREE_HPP
 
-#include <functional>
 #include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <type_traits>
 #include <vector>
-#include <deque>
-#include <memory>
 #include "binaryTreeNode.hpp"
 #include "binaryTree.hpp"
+#include "linkedBinaryTree.hpp"
 
+/*
+ *	binary tree stored as an array in level order: the root at [0], the children of [i] at [2i+1] and [2i+2]
+ *	the elements sit in one contiguous vector, a bitmap tells which slots hold an element
+ *	a slot whose parent is empty is unreachable from the root, so it is never part of the tree
+ */
 template <typename T>
 class seqBinaryTree : public binaryTree<binaryTreeNode<T>>
 {
-    using node = binaryTreeNode<T>;
-    using nodePtr = std::unique_ptr<node>;
-    using VisitFunc = std::function<void(nodePtr&)>;
+    using size_type = typename std::vector<T>::size_type;
 public:
     seqBinaryTree() = default;
-    seqBinaryTree(const std::vector<T>& v) noexcept
-        : vec_()
+    //a complete tree, every value is an element
+    explicit seqBinaryTree(std::vector<T> v)
+        : values_(std::move(v)), present_((values_.size() + 63) / 64, ~std::uint64_t{})
     {
-        auto nope = T(); //no element
-        for (const auto& i : v) {
-            if (i == nope)
-                vec_.emplace_back(nullptr);
-            else
-                vec_.emplace_back(std::make_unique<node>(i));
-        }
+        if (values_.size() % 64 != 0)
+            present_.back() = (std::uint64_t{1} << values_.size() % 64) - 1;
     }
-    ~seqBinaryTree() {vec_.clear();}
-    inline bool empty() const override {return vec_.empty();}
-    inline int height() noexcept override {return height_(0);}
-    inline int nodeCount() noexcept override {return static_cast<int>(vec_.size() - std::count(vec_.begin(), vec_.end(), nullptr));}
-    void preOrder(const VisitFunc& theVisit) noexcept
+    //std::nullopt marks an empty slot
+    explicit seqBinaryTree(const std::vector<std::optional<T>>& v);
+    inline bool empty() const override {return values_.empty();}
+    //the last slot is occupied and every ancestor of an occupied slot is too, so the depth of the last slot is the height
+    inline int height() noexcept override {return static_cast<int>(std::bit_width(values_.size()));}
+    inline int nodeCount() noexcept override
     {
-        auto size {vec_.size()};
-        /*
-         *	use stack to get the preOrder of the index (begin from 0)
-         *	if (i) is the root, then (2i+1) is leftChild and the (2i+2) is rightChild
-         */
-        std::deque<decltype (size)> stack;
-        stack.emplace_back(0);
-        while (!stack.empty()) {
-            auto tmp {stack.back()};
-            stack.pop_back();
-            if (vec_[tmp] != nullptr)
-                theVisit(vec_[tmp]);
-            if (++ ++(tmp <<= 1)< size) //push on rightChild
-                stack.emplace_back(tmp);
-            if (--tmp < size) //push on leftChild
-                stack.emplace_back(tmp);
-        }
+        int count {};
+        for (auto word : present_)
+            count += std::popcount(word);
+        return count;
+    }
+    inline size_type slotCount() const noexcept {return values_.size();} //the last occupied slot + 1
+    inline bool occupied(size_type i) const noexcept {return i < values_.size() && (present_[i / 64] >> i % 64 & 1) != 0;}
+    inline const T& value(size_type i) const noexcept {return values_[i];} //i must be occupied
+    /*
+     *	traversals, the visitor sees T& (const T& through a const tree), see visitNode for the protocol
+     *	levelOrder also takes a visitor of (element, level No., position in the level), both begin from 0
+     *	the walks move between slots by index arithmetic alone (parent (i-1)/2), so they allocate nothing,
+     *	and levelOrder is a scan of the bitmap
+     */
+    template <typename Visit>
+    bool preOrder(Visit&& theVisit) {return preOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool preOrder(Visit&& theVisit) const {return preOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool inOrder(Visit&& theVisit) {return inOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool inOrder(Visit&& theVisit) const {return inOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool postOrder(Visit&& theVisit) {return postOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool postOrder(Visit&& theVisit) const {return postOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool levelOrder(Visit&& theVisit) {return levelOrder_(*this, theVisit);}
+    template <typename Visit>
+    bool levelOrder(Visit&& theVisit) const {return levelOrder_(*this, theVisit);}
+    /*
+     *	conversions in O(n), for a search tree: the in-order of the elements is kept, the shape is not
+     *	a linkedBinaryTree (or avlTree) is flattened into a complete tree with no empty slot,
+     *	toTree rebuilds a height-balanced one from it (the in-order must be sorted and free of duplicates)
+     */
+    template <typename Alloc, typename Augment>
+    explicit seqBinaryTree(const linkedBinaryTree<T, Alloc, Augment>& theTree);
+    template <typename Alloc, typename Augment>
+    void toTree(linkedBinaryTree<T, Alloc, Augment>& theTree) const
+    {
+        std::vector<T> elements;
+        elements.reserve(values_.size());
+        inOrder([&elements](const T& x) {elements.push_back(x);});
+        theTree.build(elements.begin(), elements.end());
     }
 private:
-    std::vector<nodePtr> vec_;
-    int height_(typename std::vector<nodePtr>::size_type) noexcept;
+    std::vector<T> values_; //values of the empty slots are default constructed and never seen
+    std::vector<std::uint64_t> present_; //bit i % 64 of word i / 64 is set if slot i holds an element
+    //the left or the right child of i if it is occupied, 0 (the root, never a child) if not
+    size_type left_(size_type i) const noexcept {return occupied(2 * i + 1) ? 2 * i + 1 : 0;}
+    size_type right_(size_type i) const noexcept {return occupied(2 * i + 2) ? 2 * i + 2 : 0;}
+    static size_type parent_(size_type i) noexcept {return (i - 1) / 2;}
+    static bool isLeft_(size_type i) noexcept {return (i & 1) != 0;}
+    //Tree is seqBinaryTree or const seqBinaryTree, so the visitor sees T& or const T&
+    template <typename Tree, typename Visit>
+    static bool preOrder_(Tree&, Visit&);
+    template <typename Tree, typename Visit>
+    static bool inOrder_(Tree&, Visit&);
+    template <typename Tree, typename Visit>
+    static bool postOrder_(Tree&, Visit&);
+    template <typename Tree, typename Visit>
+    static bool levelOrder_(Tree&, Visit&);
 };
 
 template <typename T>
-int seqBinaryTree<T>::height_(typename std::vector<nodePtr>::size_type i) noexcept
+seqBinaryTree<T>::seqBinaryTree(const std::vector<std::optional<T>>& v)
+{
+    //one pass in level order: a slot is kept only if its parent was
+    size_type last {};
+    std::vector<std::uint64_t> present((v.size() + 63) / 64);
+    for (size_type i = 0; i != v.size(); ++i)
+        if (v[i].has_value() && (i == 0 || (present[(i - 1) / 2 / 64] >> (i - 1) / 2 % 64 & 1) != 0)) {
+            present[i / 64] |= std::uint64_t{1} << i % 64;
+            last = i + 1;
+        }
+    present.resize((last + 63) / 64);
+    present_ = std::move(present);
+    values_.reserve(last);
+    for (size_type i = 0; i != last; ++i)
+        values_.push_back((present_[i / 64] >> i % 64 & 1) != 0 ? *v[i] : T());
+}
+
+template <typename T>
+template <typename Alloc, typename Augment>
+seqBinaryTree<T>::seqBinaryTree(const linkedBinaryTree<T, Alloc, Augment>& theTree)
+    : seqBinaryTree(std::vector<T>(static_cast<size_type>(std::distance(theTree.begin(), theTree.end()))))
+{
+    //the slots of a complete tree taken in order receive the elements in order
+    auto it {theTree.begin()};
+    inOrder([&it](T& x) {x = *it++;});
+}
+
+template <typename T>
+template <typename Tree, typename Visit>
+bool seqBinaryTree<T>::preOrder_(Tree& tree, Visit& theVisit)
+{
+    if (tree.empty())
+        return true;
+    for (size_type i = 0; ; ) {
+        if (!visitNode(theVisit, tree.values_[i]))
+            return false;
+        if (auto l {tree.left_(i)}; l != 0)
+            i = l;
+        else if (auto r {tree.right_(i)}; r != 0)
+            i = r;
+        else { //climb to the nearest left child with a right sibling, that sibling is next
+            while (i != 0 && !(isLeft_(i) && tree.occupied(i + 1)))
+                i = parent_(i);
+            if (i == 0)
+                return true;
+            ++i;
+        }
+    }
+}
+
+template <typename T>
+template <typename Tree, typename Visit>
+bool seqBinaryTree<T>::inOrder_(Tree& tree, Visit& theVisit)
 {
-    if (i >= vec_.size())
-        return 0;
-    if (vec_[i] == nullptr)
-        return 0;
-    else {
-        auto hl {height_( (i << 1) + 1 )}; //height for leftChild
-        auto hr {height_( (i << 1) + 2 )}; //height for rightChild
-        return hl > hr ? ++hl : ++hr;
+    if (tree.empty())
+        return true;
+    size_type i {};
+    while (tree.left_(i) != 0)
+        i = tree.left_(i);
+    for (;;) {
+        if (!visitNode(theVisit, tree.values_[i]))
+            return false;
+        if (auto r {tree.right_(i)}; r != 0) { //the minimum of the right subtree
+            i = r;
+            while (tree.left_(i) != 0)
+                i = tree.left_(i);
+        } else { //climb while coming from a right child, then once more
+            while (i != 0 && !isLeft_(i))
+                i = parent_(i);
+            if (i == 0)
+                return true;
+            i = parent_(i);
+        }
     }
 }
 
+template <typename T>
+template <typename Tree, typename Visit>
+bool seqBinaryTree<T>::postOrder_(Tree& tree, Visit& theVisit)
+{
+    if (tree.empty())
+        return true;
+    //the first node in post-order below i: go left where possible, else right, down to a leaf
+    auto descend = [&tree](size_type i)
+    {
+        for (;;) {
+            if (auto l {tree.left_(i)}; l != 0)
+                i = l;
+            else if (auto r {tree.right_(i)}; r != 0)
+                i = r;
+            else
+                return i;
+        }
+    };
+    for (auto i {descend(0)}; ; ) {
+        if (!visitNode(theVisit, tree.values_[i]))
+            return false;
+        if (i == 0)
+            return true;
+        if (isLeft_(i) && tree.occupied(i + 1))
+            i = descend(i + 1);
+        else
+            i = parent_(i);
+    }
+}
+
+template <typename T>
+template <typename Tree, typename Visit>
+bool seqBinaryTree<T>::levelOrder_(Tree& tree, Visit& theVisit)
+{
+    int levelNo {-1};
+    int levelPos {};
+    size_type levelEnd {}; //the first slot of the next level
+    for (size_type w = 0; w != tree.present_.size(); ++w)
+        for (auto word {tree.present_[w]}; word != 0; word &= word - 1) {
+            auto i {w * 64 + static_cast<size_type>(std::countr_zero(word))};
+            bool goOn {};
+            if constexpr (std::is_invocable_v<Visit&, decltype (tree.values_[i]), int, int>) {
+                while (i >= levelEnd) {
+                    ++levelNo;
+                    levelPos = 0;
+                    levelEnd = 2 * levelEnd + 1;
+                }
+                goOn = visitNode(theVisit, tree.values_[i], levelNo, levelPos++);
+            } else
+                goOn = visitNode(theVisit, tree.values_[i]);
+            if (!goOn)
+                return false;
+        }
+    return true;
+}
+
 #endif // SEQBINARYTREE_HPP
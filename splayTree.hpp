@@ -0,0 +1,246 @@
+#ifndef SPLAYTREE_HPP
+#define SPLAYTREE_HPP
+
+#include "linkedBinaryTree.hpp"
+
+/*
+ *	splay tree: find, insert and erase move the element they look for (or the last node on the way) to the root,
+ *	so the keys used most stay near it, a key is found in O(log(n / its share of the finds)) amortized
+ *	the splaying is top-down: one pass from the root splits the path into the nodes less than the key and the
+ *	nodes greater than it, and joins them under the last node reached, no parent links are followed on the way
+ *	a single operation may take O(n) on a degenerate shape (sequential inserts), any series of m takes O(m log n)
+ *
+ *	SplayAfter > 1 is the read-mostly mode: find searches without changing the tree and splays only on every
+ *	SplayAfter-th hit below the root, whatever key it is (one counter of the tree, no node is written to count):
+ *	the hit that is sampled is most likely one of the hot keys, so they still come up,
+ *	but the other lookups only read the nodes, and a miss or a hit of the root does not count
+ *	insert and erase splay always
+ */
+template <typename T, typename Alloc = heapAllocator, typename Augment = noAugment, unsigned SplayAfter = 1>
+class splayTree : public linkedBinaryTree<T, Alloc, Augment>
+{
+    static_assert(SplayAfter >= 1);
+    using base = linkedBinaryTree<T, Alloc, Augment>;
+    using node = binaryTreeNode<T, Alloc, Augment>;
+    using nodePtr = typename node::nodePtr;
+public:
+    bool find(const T& theElement) noexcept {return find_(theElement);}
+    template <typename K> requires transparentKey<K, T>
+    bool find(const K& theKey) noexcept {return find_(theKey);}
+    nodePtr& insert(const T& theElement, nodePtr& t) noexcept override {return insert_(theElement, t);}
+    nodePtr& insert(T&& theElement, nodePtr& t) noexcept override {return insert_(std::move(theElement), t);}
+    bool erase(const T&, nodePtr&) noexcept override;
+    friend std::istream& operator>> (std::istream& is, splayTree<T, Alloc, Augment, SplayAfter>& t) {
+        T theElement;
+        is >> theElement;
+        if (is)
+            t.insert(std::move(theElement), t.root());
+        return is;
+    }
+private:
+    unsigned hits_ {}; //hits below the root since the last splay of a find, the read-mostly mode only
+    static nodePtr rotateLeft_(nodePtr) noexcept;
+    static nodePtr rotateRight_(nodePtr) noexcept;
+    template <typename K>
+    static void splay_(const K&, nodePtr&) noexcept;
+    template <typename K>
+    bool find_(const K&) noexcept;
+    template <typename E>
+    nodePtr& insert_(E&&, nodePtr&) noexcept;
+};
+
+//the splayTree for read-mostly use: a find changes the tree only on every 8th hit below the root
+template <typename T, typename Alloc = heapAllocator, typename Augment = noAugment>
+using readMostlySplayTree = splayTree<T, Alloc, Augment, 8>;
+
+/*
+ *	the rotations of the zig-zig step, t goes down and its child comes up and is returned
+ *	t keeps its subtrees below it, so its height is final, the one of the returned node is refreshed by splay_
+ */
+template <typename T, typename Alloc, typename Augment, unsigned SplayAfter>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr splayTree<T, Alloc, Augment, SplayAfter>::rotateRight_(nodePtr t) noexcept
+{
+    auto y {std::move(t->leftChild_)};
+    t->leftChild_ = std::move(y->rightChild_);
+    if (t->leftChild_ != nullptr)
+        t->leftChild_->parent_ = t.get();
+    t->parent_ = y.get();
+    base::updateNode(t);
+    y->rightChild_ = std::move(t);
+    return y;
+}
+
+template <typename T, typename Alloc, typename Augment, unsigned SplayAfter>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr splayTree<T, Alloc, Augment, SplayAfter>::rotateLeft_(nodePtr t) noexcept
+{
+    auto y {std::move(t->rightChild_)};
+    t->rightChild_ = std::move(y->leftChild_);
+    if (t->rightChild_ != nullptr)
+        t->rightChild_->parent_ = t.get();
+    t->parent_ = y.get();
+    base::updateNode(t);
+    y->leftChild_ = std::move(t);
+    return y;
+}
+
+/*
+ *	top-down splay of root: on the way down, a node greater than the element is hung with its right subtree
+ *	as the new minimum of "greater", a smaller one as the new maximum of "less"
+ *	(two steps to the same side rotate first, which halves the depth of that path)
+ *	the last node reached becomes the root over less and greater, its own subtrees fill the holes they left
+ *
+ *	        less           greater             t
+ *	       .    .         .      .            . .
+ *	      ..    lMax     gMin    ..   ==>  less   greater
+ *	            .  .    .  .
+ *	              hole  hole
+ *	the nodes hung on the way got new subtrees, their heights are refreshed bottom-up from lMax and gMin
+ */
+template <typename T, typename Alloc, typename Augment, unsigned SplayAfter>
+template <typename K>
+void splayTree<T, Alloc, Augment, SplayAfter>::splay_(const K& theElement, nodePtr& root) noexcept
+{
+    if (root == nullptr)
+        return;
+    auto parent {root->parent_};
+    auto t {std::move(root)};
+    nodePtr less, greater;
+    auto lessHole {&less}; //rightChild_ of the maximum of less
+    auto greaterHole {&greater}; //leftChild_ of the minimum of greater
+    node* lessMax {nullptr};
+    node* greaterMin {nullptr};
+    for (;;) {
+        if (theElement < t->element_) {
+            if (t->leftChild_ != nullptr && theElement < t->leftChild_->element_)
+                t = rotateRight_(std::move(t));
+            if (t->leftChild_ == nullptr)
+                break;
+            auto next {std::move(t->leftChild_)};
+            t->parent_ = greaterMin;
+            *greaterHole = std::move(t);
+            greaterMin = greaterHole->get();
+            greaterHole = &greaterMin->leftChild_;
+            t = std::move(next);
+        } else if (t->element_ < theElement) {
+            if (t->rightChild_ != nullptr && t->rightChild_->element_ < theElement)
+                t = rotateLeft_(std::move(t));
+            if (t->rightChild_ == nullptr)
+                break;
+            auto next {std::move(t->rightChild_)};
+            t->parent_ = lessMax;
+            *lessHole = std::move(t);
+            lessMax = lessHole->get();
+            lessHole = &lessMax->rightChild_;
+            t = std::move(next);
+        } else
+            break;
+    }
+    *lessHole = std::move(t->leftChild_);
+    if (*lessHole != nullptr)
+        (*lessHole)->parent_ = lessMax;
+    *greaterHole = std::move(t->rightChild_);
+    if (*greaterHole != nullptr)
+        (*greaterHole)->parent_ = greaterMin;
+    for (auto p = lessMax; p != nullptr; p = p->parent_) //the tops of less and greater have no parent yet
+        base::updateNode(p);
+    for (auto p = greaterMin; p != nullptr; p = p->parent_)
+        base::updateNode(p);
+    t->leftChild_ = std::move(less);
+    if (t->leftChild_ != nullptr)
+        t->leftChild_->parent_ = t.get();
+    t->rightChild_ = std::move(greater);
+    if (t->rightChild_ != nullptr)
+        t->rightChild_->parent_ = t.get();
+    t->parent_ = parent;
+    base::updateNode(t);
+    root = std::move(t);
+    if (parent != nullptr) //a subtree was splayed, its height may have changed
+        base::updatePath(parent, nullptr);
+}
+
+template <typename T, typename Alloc, typename Augment, unsigned SplayAfter>
+template <typename K>
+bool splayTree<T, Alloc, Augment, SplayAfter>::find_(const K& theElement) noexcept
+{
+    auto& root {this->root()};
+    if constexpr (SplayAfter == 1) {
+        splay_(theElement, root);
+        return root != nullptr && root->element_ == theElement;
+    } else {
+        for (auto t = root.get(); t != nullptr; ) {
+            if (t->element_ == theElement) {
+                if (t != root.get() && ++hits_ == SplayAfter) {
+                    hits_ = 0;
+                    splay_(theElement, root);
+                }
+                return true;
+            }
+            t = ((t->element_ < theElement) ? t->rightChild_ : t->leftChild_).get();
+        }
+        return false;
+    }
+}
+
+/*
+ *	splay the element (or its neighbour) up, then the new node takes the root and splits the old one by the element
+ *	E is const T& or T, the side is decided before an rvalue is moved into the new node
+ */
+template <typename T, typename Alloc, typename Augment, unsigned SplayAfter>
+template <typename E>
+typename binaryTreeNode<T, Alloc, Augment>::nodePtr& splayTree<T, Alloc, Augment, SplayAfter>::insert_(E&& theElement, nodePtr& t) noexcept
+{
+    splay_(theElement, t);
+    if (t != nullptr && t->element_ == theElement)
+        return t; //the element was in the tree already
+    auto parent {t == nullptr ? nullptr : t->parent_};
+    bool less {t != nullptr && theElement < t->element_};
+    auto n {this->makeNode(std::forward<E>(theElement))};
+    if (t != nullptr) {
+        auto& beyond {less ? n->leftChild_ : n->rightChild_};
+        beyond = std::move(less ? t->leftChild_ : t->rightChild_); //the part of t on the side of the element moves under n
+        if (beyond != nullptr)
+            beyond->parent_ = n.get();
+        base::updateNode(t);
+        t->parent_ = n.get();
+        (less ? n->rightChild_ : n->leftChild_) = std::move(t);
+        base::updateNode(n);
+    }
+    n->parent_ = parent;
+    t = std::move(n);
+    if (parent != nullptr)
+        base::updatePath(parent, nullptr);
+    return t;
+}
+
+/*
+ *	splay the element up and take it out, then the maximum of its left subtree is splayed up there, with no right child
+ *	the node taken out lives to the end, the element may be a reference to its own
+ */
+template <typename T, typename Alloc, typename Augment, unsigned SplayAfter>
+bool splayTree<T, Alloc, Augment, SplayAfter>::erase(const T& theElement, nodePtr& t) noexcept
+{
+    splay_(theElement, t);
+    if (t == nullptr || !(t->element_ == theElement))
+        return false;
+    auto parent {t->parent_};
+    auto erased {std::move(t)};
+    auto right {std::move(erased->rightChild_)};
+    if (erased->leftChild_ == nullptr)
+        t = std::move(right);
+    else {
+        t = std::move(erased->leftChild_);
+        t->parent_ = nullptr;
+        splay_(theElement, t); //every element of left is less, so its maximum comes up
+        t->rightChild_ = std::move(right);
+        if (t->rightChild_ != nullptr)
+            t->rightChild_->parent_ = t.get();
+        base::updateNode(t);
+    }
+    if (t != nullptr)
+        t->parent_ = parent;
+    if (parent != nullptr)
+        base::updatePath(parent, nullptr);
+    return true;
+}
+
+#endif // SPLAYTREE_HPP
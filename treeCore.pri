@@ -0,0 +1,31 @@
+# the tree containers: header only and free of Qt, so any qmake project can use them with
+#   include(path/to/treeCore.pri)
+# (treeLocator.hpp is not part of it, it lays trees out with QPointF)
+
+CONFIG += c++20 thread
+INCLUDEPATH += $$PWD
+
+# qmake CONFIG+=avx2 targets AVX2, which the batch lookup of frozenTree uses (the binary then needs a CPU with it)
+avx2 {
+    msvc: QMAKE_CXXFLAGS += /arch:AVX2
+    else: QMAKE_CXXFLAGS += -mavx2
+}
+
+HEADERS += \
+    $$PWD/avlTree.hpp \
+    $$PWD/bPlusTree.hpp \
+    $$PWD/binaryTree.hpp \
+    $$PWD/binaryTreeNode.hpp \
+    $$PWD/concurrentAvlTree.hpp \
+    $$PWD/epochReclaimer.hpp \
+    $$PWD/forkJoin.hpp \
+    $$PWD/frozenTree.hpp \
+    $$PWD/linkedBinaryTree.hpp \
+    $$PWD/nodeAllocator.hpp \
+    $$PWD/nodeAugment.hpp \
+    $$PWD/persistentAvlTree.hpp \
+    $$PWD/rcuAvlTree.hpp \
+    $$PWD/redBlackTree.hpp \
+    $$PWD/seqBinaryTree.hpp \
+    $$PWD/splayTree.hpp \
+    $$PWD/treeSnapshot.hpp
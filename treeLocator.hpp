@@ -5,171 +5,253 @@
 #include <string>
 #include <deque>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <utility>
-#include <numeric>
+#include <algorithm>
+#include <type_traits>
 #include <QPoint>
 #include <QLineF>
 #include "linkedBinaryTree.hpp"
 
-template <typename T>
+/*
+ *	Tree: linkedBinaryTree (and the trees derived from it) or persistentAvlTree
+ *	a node of level L (the root is level 0) has a slot of the complete tree, 1 to 2^L from the left
+ *	(the children of slot s are 2s - 1 and 2s), and is drawn at x = slot * width / (2^L + 1),
+ *	pushed right to keep 2 radius off the node before it on its level
+ *	every level is kept as a row of its slots, left to right, so the level-order index of a node
+ *	is the size of the levels above (a prefix sum kept with the rows) plus its place in the row
+ *	the tree is not copied: the locator views it, so it must outlive the locator, and update is called
+ *	after every change of it
+ *	update lays out another tree by walking it and the current one together from the root:
+ *	a node found at the same place in both (with persistentAvlTree, nodes never change, so its whole subtree)
+ *	is skipped, only the places whose node changed are visited and only the rows they touch are swept again,
+ *	so an insert or erase costs its path and the subtrees its rotations moved
+ *	(the nodes of linkedBinaryTree change in place, so every place is visited again)
+ *	slots are 64 bits wide, enough for 64 levels
+ */
+template <typename T, typename Tree = linkedBinaryTree<T>>
 class treeLocate
 {
-    using nodePtr = std::unique_ptr<binaryTreeNode<T>>;
+    using nodePtr = std::remove_cvref_t<decltype(std::declval<const Tree&>().root())>;
+    using node = std::remove_const_t<typename nodePtr::element_type>;
     using size_type = std::vector<QPointF>::size_type;
 public:
-    explicit treeLocate(const linkedBinaryTree<T>& tree, double radius, double height, double width, double beginFrom = 0)
+    explicit treeLocate(const Tree& tree, double radius, double height, double width, double beginFrom = 0)
         : radius_(radius)
         , height_(height - 120)
         , width_(width)
         , beginFrom_(beginFrom)
-        , points_()
-        , lines_()
-        , passerby_()
-        , path_()
-        , tree_(tree)
+        , rows_()
+        , tree_(&tree)
     {
-        if (!tree_.empty())
-            prepare();
-    }
-    inline std::vector<QPointF> points() noexcept {return points_;}
-    inline std::vector<QLineF> lines() noexcept {return lines_;}
-    std::vector<size_type> findPath(const T theElement) noexcept
-    {
-        path_.clear();
-        passerby_.clear();
-        path_.resize(0);
-        passerby_.resize(0);
-        findPasserby(theElement, tree_.root());
-        return find();
+        if constexpr (shared_)
+            laidOut_ = tree.root();
+        place_(nullptr, tree.root().get());
     }
+    //lay out tree (the one viewed so far after a change, or another one) with radius from now on
+    void update(const Tree&, double radius);
+    inline void setBeginFrom(double beginFrom) noexcept {beginFrom_ = beginFrom;}
+    //in level order
+    std::vector<QPointF> points() const;
+    std::vector<QLineF> lines() const; //the line to every node but the root, in the order of points()
+    //the level-order indices of the nodes from the root down to theElement, empty if it is not in the tree
+    std::vector<size_type> findPath(const T&) const;
 private:
+    struct place
+    {
+        std::uint64_t slot;
+        double x; //from beginFrom_
+    };
+    //the rows swept again after a change: from the first slot changed, on at least up to the last one
+    struct sweep
+    {
+        std::uint64_t from {UINT64_MAX};
+        std::uint64_t to {};
+    };
+    static constexpr bool shared_ {std::is_const_v<typename nodePtr::element_type>}; //a node is never changed
     double radius_;
     double height_;
     double width_;
     double beginFrom_;
-    std::vector<QPointF> points_;
-    std::vector<QLineF> lines_;
-    std::vector<T> passerby_;
-    std::vector<size_type> path_;
-    linkedBinaryTree<T> tree_;
-    void prepare() noexcept;
-    void findPasserby(const T, const nodePtr&) noexcept;
-    std::vector<size_type> find() noexcept;
+    std::vector<std::vector<place>> rows_; //rows_[L]: the nodes of level L by slot
+    std::vector<sweep> sweeps_;
+    std::vector<size_type> levelBegin_ {0}; //levelBegin_[L]: the level-order index of the first node of level L
+    const Tree* tree_;
+    //the root laid out, which keeps the nodes of persistentAvlTree alive for the next update to compare with
+    //(nothing to keep with linkedBinaryTree, it changes in place)
+    std::conditional_t<shared_, nodePtr, std::nullptr_t> laidOut_ {};
+    void place_(const node*, const node*);
+    void mark_(std::size_t, std::uint64_t, bool);
+    void sweep_(std::size_t) noexcept;
+    size_type index_(std::size_t, std::uint64_t) const noexcept;
 };
 
-template <typename T>
-void treeLocate<T>::prepare() noexcept
+template <typename T, typename Tree>
+void treeLocate<T, Tree>::update(const Tree& tree, double radius)
 {
-    /*
-     *	show for all the screen
-     *	dHeight (delta height): height between levels
-     */
-    const double dHeight = height_ / tree_.height();
-    points_.emplace_back(beginFrom_ + width_ / 2, 0);//initialize for the root
-    int levelNo = 0;//current level No. (begin from 0)
-    int levelCnt = 0;//current level node count
-    const std::vector<int> levelInfo = tree_.levelInfo();
-    double dist = width_ / ((1 << levelNo) + 1);//current level distance
-    double lowDist = width_ / ((1 << (levelNo + 1)) + 1);//lower level distance
-    tree_.levelOrder([this, &dHeight, &levelNo, &levelCnt, &levelInfo, &dist, &lowDist](const auto& p)
-    {
-        ++levelCnt;
-        if (p->leftChild_ != nullptr){
-            int index = 0;
-            if (levelNo != 0)
-                index = std::accumulate(levelInfo.begin(), levelInfo.begin() + levelNo, 0) //count all higher level nodes
-                        + levelCnt //current level node(s)
-                        - 1; //-1 for index
-            double parentX = points_[index].x();
-            double parentY = points_[index].y();
-            //add points
-            unsigned upLevelTimes = static_cast<unsigned>(std::round((parentX - beginFrom_) / dist));
-            unsigned lowLevelLeftTimes = (upLevelTimes << 1) - 1;
-
-            double childX = beginFrom_ + lowLevelLeftTimes * lowDist;
-            double childY = dHeight * (levelNo + 1);
-            double otherX = (*(points_.cend() - 1)).x();
-            double otherY = (*(points_.cend() - 1)).y();
-            if (otherY == childY) {
-                if (childX - otherX < 2 * radius_)
-                    childX = otherX + 2 * radius_;
-            }
+    if (radius != radius_) { //every push may change
+        radius_ = radius;
+        sweeps_.resize(rows_.size());
+        for (auto& s : sweeps_)
+            s = {0, UINT64_MAX};
+    }
+    tree_ = &tree;
+    if constexpr (shared_) {
+        auto was {std::move(laidOut_)}; //its nodes stay alive for the walk
+        laidOut_ = tree.root();
+        place_(was.get(), laidOut_.get());
+    } else {
+        rows_.clear();
+        sweeps_.clear();
+        place_(nullptr, tree.root().get());
+    }
+}
 
+/*
+ *	walk the old and the new tree together, place by place (without recursion, a plain tree may be deep)
+ *	and mark every place whose node appeared, went, or is another one now
+ */
+template <typename T, typename Tree>
+void treeLocate<T, Tree>::place_(const node* was, const node* now)
+{
+    struct visit
+    {
+        const node* was;
+        const node* now;
+        std::size_t level;
+        std::uint64_t slot;
+    };
+    std::vector<visit> stack {{was, now, 0, 1}};
+    while (!stack.empty()) {
+        auto v {stack.back()};
+        stack.pop_back();
+        if (v.was == v.now && (shared_ || v.now == nullptr)) //the same subtree in the same place
+            continue;
+        mark_(v.level, v.slot, v.now != nullptr);
+        //the left one is visited first, so a row is met left to right (a new row is only appended to)
+        stack.push_back({v.was == nullptr ? nullptr : v.was->rightChild_.get(),
+                         v.now == nullptr ? nullptr : v.now->rightChild_.get(), v.level + 1, 2 * v.slot});
+        stack.push_back({v.was == nullptr ? nullptr : v.was->leftChild_.get(),
+                         v.now == nullptr ? nullptr : v.now->leftChild_.get(), v.level + 1, 2 * v.slot - 1});
+    }
+    for (std::size_t level = 0; level != rows_.size(); ++level)
+        sweep_(level);
+    while (!rows_.empty() && rows_.back().empty())
+        rows_.pop_back();
+    sweeps_.resize(rows_.size());
+    levelBegin_.resize(rows_.size() + 1);
+    for (std::size_t level = 0; level != rows_.size(); ++level)
+        levelBegin_[level + 1] = levelBegin_[level] + rows_[level].size();
+}
 
-            points_.emplace_back(childX, childY);
-            //add lines
-            double distance = parentX - childX;
-            double hypotenuse = std::sqrt(std::pow(distance, 2) + std::pow(dHeight - radius_, 2));
-            double x = distance * radius_ / hypotenuse;
-            double y = (dHeight - radius_) * radius_ / hypotenuse;
-            lines_.emplace_back(parentX - x, parentY + y,
-                        childX, parentY + dHeight - radius_);
-        }
-        if (p->rightChild_ != nullptr){
-            int index = 0;
-            if (levelNo != 0)
-                index = std::accumulate(levelInfo.begin(), levelInfo.begin() + levelNo, 0) //count all higher level nodes
-                        + levelCnt //current level node(s)
-                        - 1; //-1 for index
-            double parentX = points_[index].x();
-            double parentY = points_[index].y();
-            //add points
-            unsigned upLevelTimes = static_cast<unsigned>(std::round((parentX  - beginFrom_) / dist));
-            unsigned lowLevelRightTimes = upLevelTimes << 1;
+//the place (level, slot) holds a node if present: add or drop it from the row, it is swept again
+template <typename T, typename Tree>
+void treeLocate<T, Tree>::mark_(std::size_t level, std::uint64_t slot, bool present)
+{
+    if (level >= rows_.size()) {
+        rows_.resize(level + 1);
+        sweeps_.resize(level + 1);
+    }
+    auto& row {rows_[level]};
+    auto i {std::lower_bound(row.begin(), row.end(), slot, [](const place& p, std::uint64_t s) {return p.slot < s;})};
+    bool there {i != row.end() && i->slot == slot};
+    if (present && !there)
+        row.insert(i, {slot, 0.0});
+    else if (!present && there)
+        row.erase(i);
+    auto& s {sweeps_[level]};
+    s.from = std::min(s.from, slot);
+    s.to = std::max(s.to, slot);
+}
 
-            double childX = beginFrom_ + lowLevelRightTimes * lowDist;
-            double childY = dHeight * (levelNo + 1);
-            double otherX = (*(points_.cend() - 1)).x();
-            double otherY = (*(points_.cend() - 1)).y();
-            if (otherY == childY) {
-                if (childX - otherX < 2 * radius_)
-                    childX = otherX + 2 * radius_;
-            }
+//recompute the x of a row from the first slot marked, until past the last one nothing moves any more
+template <typename T, typename Tree>
+void treeLocate<T, Tree>::sweep_(std::size_t level) noexcept
+{
+    auto& s {sweeps_[level]};
+    if (s.from == UINT64_MAX)
+        return;
+    auto& row {rows_[level]};
+    const double dist {width_ / (std::ldexp(1.0, static_cast<int>(level)) + 1)}; //between two slots
+    auto i {std::lower_bound(row.begin(), row.end(), s.from, [](const place& p, std::uint64_t slot) {return p.slot < slot;})};
+    for (; i != row.end(); ++i) {
+        auto x {static_cast<double>(i->slot) * dist};
+        if (i != row.begin() && x - (i - 1)->x < 2 * radius_)
+            x = (i - 1)->x + 2 * radius_;
+        if (x == i->x && i->slot > s.to)
+            break;
+        i->x = x;
+    }
+    s = {};
+}
 
+template <typename T, typename Tree>
+std::vector<QPointF> treeLocate<T, Tree>::points() const
+{
+    std::vector<QPointF> points;
+    points.reserve(levelBegin_.back());
+    const double dHeight {height_ / static_cast<double>(rows_.size())}; //height between levels
+    for (size_type level = 0; level != rows_.size(); ++level)
+        for (const auto& p : rows_[level])
+            points.emplace_back(beginFrom_ + p.x, dHeight * static_cast<double>(level));
+    return points;
+}
 
-            points_.emplace_back(childX, childY);
-            //add lines
-            double distance = childX - parentX;
-            double hypotenuse = std::sqrt(std::pow(distance, 2) + std::pow(dHeight - radius_, 2));
-            double x = distance * radius_ / hypotenuse;
-            double y = (dHeight - radius_) * radius_ / hypotenuse;
-            lines_.emplace_back(parentX + x, parentY + y,
-                        childX, parentY + dHeight - radius_);
-        }
-        if (levelCnt == levelInfo[levelNo]){//current level is done
-            ++levelNo;
-            dist = width_ / ((1 << levelNo) + 1);
-            lowDist = width_ / ((1 << (levelNo + 1)) + 1);
-            levelCnt = 0;
+/*
+ *	the parent of slot s is slot (s + 1) / 2 one level up, so the parents of a row come left to right too
+ *	a line runs from the circle of the parent, pointing at the child, to the top of the child's circle
+ */
+template <typename T, typename Tree>
+std::vector<QLineF> treeLocate<T, Tree>::lines() const
+{
+    std::vector<QLineF> lines;
+    lines.reserve(levelBegin_.back());
+    const double dHeight {height_ / static_cast<double>(rows_.size())};
+    const double drop {dHeight - radius_};
+    for (size_type level = 1; level < rows_.size(); ++level) {
+        auto parent {rows_[level - 1].cbegin()};
+        const double parentY {dHeight * static_cast<double>(level - 1)};
+        for (const auto& p : rows_[level]) {
+            while (parent->slot != (p.slot + 1) / 2)
+                ++parent;
+            double distance = p.x - parent->x;
+            double hypotenuse = std::sqrt(distance * distance + drop * drop);
+            lines.emplace_back(beginFrom_ + parent->x + distance * radius_ / hypotenuse, parentY + drop * radius_ / hypotenuse,
+                               beginFrom_ + p.x, parentY + drop);
         }
-    });
+    }
+    return lines;
 }
 
-template <typename T>
-void treeLocate<T>::findPasserby(const T theElement, const std::unique_ptr<binaryTreeNode<T>>& t) noexcept
+//the level-order index of the node in (level, slot): the levels above, then its place in the row
+template <typename T, typename Tree>
+typename treeLocate<T, Tree>::size_type treeLocate<T, Tree>::index_(std::size_t level, std::uint64_t slot) const noexcept
 {
-    auto tmp {t->element_};
-    passerby_.emplace_back(tmp);
-    if (tmp < theElement)
-        findPasserby(theElement, t->rightChild_);
-    else if (tmp > theElement)
-        findPasserby(theElement, t->leftChild_);
+    const auto& row {rows_[level]};
+    auto i {std::lower_bound(row.begin(), row.end(), slot, [](const place& p, std::uint64_t s) {return p.slot < s;})};
+    return levelBegin_[level] + static_cast<size_type>(i - row.begin());
 }
 
-template <typename T>
-std::vector<std::vector<QPointF>::size_type> treeLocate<T>::find() noexcept
+//one descent from the root, the slot of every node passed is known on the way, O(h log n)
+template <typename T, typename Tree>
+std::vector<typename treeLocate<T, Tree>::size_type> treeLocate<T, Tree>::findPath(const T& theElement) const
 {
-    size_type cnt {};
-    size_type index {}; //index of passerby_
-    tree_.levelOrder([this, &cnt, &index](const auto& p)
-    {
-        if (path_.size() != passerby_.size())
-            if (p->element_ == passerby_[index]) {
-                ++index;
-                path_.emplace_back(cnt);
-            }
-        ++cnt;
-    });
-    return path_;
+    std::vector<size_type> path;
+    const node* t {tree_->root().get()};
+    std::size_t level {};
+    std::uint64_t slot {1};
+    for (; t != nullptr; ++level) {
+        path.emplace_back(index_(level, slot));
+        if (t->element_ < theElement) {
+            t = t->rightChild_.get();
+            slot = 2 * slot;
+        } else if (theElement < t->element_) {
+            t = t->leftChild_.get();
+            slot = 2 * slot - 1;
+        } else
+            return path;
+    }
+    return {}; //fell off the tree: not there
 }
 #endif // TREELOCATOR_H
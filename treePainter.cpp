@@ -41,7 +41,7 @@ treePainter::treePainter(double radius, double height, double width, QWidget *pa
     });
 }
 
-QString treePainter::info(QString& s, const std::unique_ptr<avlTree<int>>& tree) noexcept
+QString treePainter::info(QString& s, const std::unique_ptr<treeType>& tree) noexcept
 {
     s.append(tr("height: ") + QString::number(tree->height()) + '\n');
     s.append(tr("node count: ") + QString::number(tree->nodeCount()) + '\n');
@@ -53,25 +53,25 @@ QString treePainter::info(QString& s, const std::unique_ptr<avlTree<int>>& tree)
     s.append(tr("preOrder: "));
     tree->preOrder([&s](const auto& p)
     {
-        s.append(QString::number(p->element_) + ' ');
+        s.append(QString::number(p.element_) + ' ');
     });
     s.append('\n');
     s.append(tr("inOrder: "));
     tree->inOrder([&s](const auto& p)
     {
-        s.append(QString::number(p->element_) + ' ');
+        s.append(QString::number(p.element_) + ' ');
     });
     s.append('\n');
     s.append(tr("postOrder: "));
     tree->postOrder([&s](const auto& p)
     {
-        s.append(QString::number(p->element_) + ' ');
+        s.append(QString::number(p.element_) + ' ');
     });
     s.append('\n');
     s.append(tr("levelOrder: "));
     tree->levelOrder([&s](const auto& p)
     {
-        s.append(QString::number(p->element_) + ' ');
+        s.append(QString::number(p.element_) + ' ');
     });
     s.append('\n');
     return s;
@@ -91,23 +91,26 @@ void treePainter::on_insertNode_clicked()
 {
     QString str = ui->insertContent->toPlainText().simplified();
     QStringList strList = str.split(" ");
+    std::vector<int> keys;
+    keys.reserve(strList.size());
+    for (auto i = strList.cbegin(); i != strList.cend(); ++i)
+        keys.emplace_back((*i).toInt());
     if (oldTree_ != nullptr) {
-        oldTree_ = std::make_unique<avlTree<int>>(*newTree_);
-        for (auto i = strList.cbegin(); i != strList.cend(); ++i)
-            newTree_->insert((*i).toInt(), newTree_->root());
+        oldTree_ = std::make_unique<treeType>(*newTree_); //snapshot, shares every node with newTree_
+        if (newTree_->empty())
+            newTree_->build(keys); //O(n) balanced build instead of n inserts
+        else
+            for (const auto& i : keys)
+                newTree_->insert(i);
     } else { //initialize
-        oldTree_ = std::make_unique<avlTree<int>>();
-        newTree_ = std::make_unique<avlTree<int>>();
-        for (auto i = strList.cbegin(); i != strList.cend(); ++i) {
-            oldTree_->insert((*i).toInt(), oldTree_->root());
-            newTree_->insert((*i).toInt(), newTree_->root());
-        }
+        newTree_ = std::make_unique<treeType>();
+        newTree_->build(keys);
+        oldTree_ = std::make_unique<treeType>(*newTree_);
     }
     int diff = newTree_->height() - oldTree_->height();
     if (newTree_->height() > 5 && newTree_->height() < 8)
         radius_ -= diff * 5;
-    oldLocator_ = std::make_unique<treeLocate<int>>(std::ref(*oldTree_), radius_, height_, width_/2);
-    newLocator_ = std::make_unique<treeLocate<int>>(std::ref(*newTree_), radius_, height_, width_/2, width_/2); //begin from center
+    locate();
     //ui->insertContent->clear();
     update();
     oldInfo_.clear();
@@ -120,24 +123,17 @@ void treePainter::on_eraseNode_clicked()
 {
     QString str = ui->eraseContent->toPlainText().simplified();
     QStringList strList = str.split(" ");
-    if (newTree_->root()) {
-        oldTree_ = std::make_unique<avlTree<int>>(*newTree_);
+    if (!newTree_->empty()) {
+        oldTree_ = std::make_unique<treeType>(*newTree_); //snapshot, shares every node with newTree_
         for (auto i = strList.cbegin(); i != strList.cend(); ++i)
-            newTree_->erase((*i).toInt(), newTree_->root());
+            newTree_->erase((*i).toInt());
         int diff = oldTree_->height() - newTree_->height();
         if (newTree_->height() > 5 && newTree_->height() < 8)
             radius_ += diff * 5;
-    } else
-        oldTree_->root() = nullptr;
-    if (newTree_->root()) {
-        auto levelInfo = newTree_->levelInfo();
-        oldLocator_ = std::make_unique<treeLocate<int>>(std::ref(*oldTree_), radius_, height_, width_/2);
-        newLocator_ = std::make_unique<treeLocate<int>>(std::ref(*newTree_), radius_, height_, width_/2, width_/2);
-    } else {
-        oldTree_->root() = nullptr;
-        newLocator_ = nullptr;
-        oldLocator_ = nullptr;
     }
+    if (newTree_->empty())
+        oldTree_->clear();
+    locate();
 
     //ui->eraseContent->clear();
     update();
@@ -147,6 +143,30 @@ void treePainter::on_eraseNode_clicked()
     ui->newTreeInfo->setPlainText(info(newInfo_, newTree_));
 }
 
+/*
+ *	the old tree is the last new one, so its layout is taken over and moved to the left half,
+ *	and the new layout is a copy of it updated to the new tree: only the places that changed are laid out again
+ */
+void treePainter::locate()
+{
+    if (newTree_->empty()) {
+        newLocator_ = nullptr;
+        oldLocator_ = nullptr;
+        return;
+    }
+    if (newLocator_ == nullptr) {
+        oldLocator_ = std::make_unique<locatorType>(std::ref(*oldTree_), radius_, height_, width_/2);
+        newLocator_ = std::make_unique<locatorType>(std::ref(*newTree_), radius_, height_, width_/2, width_/2); //begin from center
+        return;
+    }
+    oldLocator_ = std::move(newLocator_);
+    oldLocator_->setBeginFrom(0);
+    oldLocator_->update(*oldTree_, radius_); //the same tree, only a new radius moves nodes
+    newLocator_ = std::make_unique<locatorType>(*oldLocator_);
+    newLocator_->setBeginFrom(width_/2);
+    newLocator_->update(*newTree_, radius_);
+}
+
 void treePainter::paintEvent([[maybe_unused]]QPaintEvent *event)
 {
     QPainter painter(this);
@@ -186,11 +206,11 @@ void treePainter::paintEvent([[maybe_unused]]QPaintEvent *event)
         contents_.resize(0);
         oldTree_->levelOrder([this](const auto& p)
         {
-            contents_.emplace_back(p->element_);
+            contents_.emplace_back(p.element_);
         });
         newTree_->levelOrder([this](const auto& p)
         {
-            contents_.emplace_back(p->element_);
+            contents_.emplace_back(p.element_);
         });
 
         painter.save();
@@ -7,7 +7,7 @@
 #include <QPainter>
 #include <QTimer>
 #include "treeLocator.hpp"
-#include "avlTree.hpp"
+#include "persistentAvlTree.hpp"
 
 namespace Ui {
 class treePainter;
@@ -17,9 +17,11 @@ class treePainter : public QWidget
 {
     Q_OBJECT
     using size_type = std::vector<QPointF>::size_type;
+    using treeType = persistentAvlTree<int>; //copying it is an O(1) snapshot
+    using locatorType = treeLocate<int, treeType>;
 public:
     explicit treePainter(double, double, double, QWidget *parent = nullptr);
-    QString info(QString&, const std::unique_ptr<avlTree<int>>&) noexcept;
+    QString info(QString&, const std::unique_ptr<treeType>&) noexcept;
     ~treePainter();
 private slots:
     void on_insertNode_clicked();
@@ -28,6 +30,7 @@ private slots:
 protected:
     void paintEvent(QPaintEvent* event) Q_DECL_OVERRIDE;
 private:
+    void locate();
     Ui::treePainter *ui;
     double radius_;
     double height_;
@@ -39,11 +42,11 @@ private:
     std::vector<QLineF> lines_;
     std::vector<int> contents_;
     QString oldInfo_;
-    std::unique_ptr<avlTree<int>> oldTree_;
+    std::unique_ptr<treeType> oldTree_;
     QString newInfo_;
-    std::unique_ptr<avlTree<int>> newTree_;
-    std::unique_ptr<treeLocate<int>> oldLocator_;
-    std::unique_ptr<treeLocate<int>> newLocator_;
+    std::unique_ptr<treeType> newTree_;
+    std::unique_ptr<locatorType> oldLocator_;
+    std::unique_ptr<locatorType> newLocator_;
 };
 
 #endif // TREEPAINTER_H
@@ -0,0 +1,184 @@
+#ifndef TREESNAPSHOT_HPP
+#define TREESNAPSHOT_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+ *	binary snapshot of a search tree, written by linkedBinaryTree::saveSnapshot and read back by loadSnapshot
+ *	byte order of the host (checked to be little endian), a 32-byte header and two sections:
+ *
+ *	  "TREESNAP"  uint32 version  uint32 key bytes  uint64 count  uint32 flags  uint32 0
+ *	  count keys, the raw bytes of T in increasing order
+ *	  if flags & snapshotHeader::shape: the shape, 2 bits per node in pre-order (bit 0: it has a left child,
+ *	  bit 1: a right one), 4 nodes to the byte, the first node in the low bits
+ *
+ *	the keys in order are all a balanced rebuild needs, the shape puts every node back where it was
+ *	keys are copied bytewise, so T must be trivially copyable
+ */
+struct snapshotHeader
+{
+    static constexpr char magicBytes[8] {'T', 'R', 'E', 'E', 'S', 'N', 'A', 'P'};
+    static constexpr std::uint32_t currentVersion {1};
+    static constexpr std::uint32_t shape {1};
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t keyBytes;
+    std::uint64_t count;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+    //the file size a header like this one needs, 0 if it does not fit a snapshot of T
+    template <typename T>
+    std::uint64_t fileSize() const noexcept
+    {
+        if (std::memcmp(magic, magicBytes, sizeof(magic)) != 0 || version != currentVersion || keyBytes != sizeof(T)
+            || count > (UINT64_MAX - sizeof(snapshotHeader)) / (sizeof(T) + 1))
+            return 0;
+        return sizeof(snapshotHeader) + count * sizeof(T) + ((flags & shape) != 0 ? (count + 3) / 4 : 0);
+    }
+};
+static_assert(sizeof(snapshotHeader) == 32 && std::is_trivially_copyable_v<snapshotHeader>);
+
+//the keys of a snapshot as a forward range, read bytewise, so the mapping needs no alignment
+template <typename T>
+class snapshotKeys
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = T;
+    snapshotKeys() = default;
+    explicit snapshotKeys(const unsigned char* p) noexcept : p_(p) { }
+    T operator*() const noexcept
+    {
+        T theElement;
+        std::memcpy(&theElement, p_, sizeof(T));
+        return theElement;
+    }
+    snapshotKeys& operator++() noexcept
+    {
+        p_ += sizeof(T);
+        return *this;
+    }
+    snapshotKeys operator++(int) noexcept
+    {
+        auto tmp {*this};
+        p_ += sizeof(T);
+        return tmp;
+    }
+    bool operator==(const snapshotKeys& rhs) const noexcept {return p_ == rhs.p_;}
+    friend difference_type operator-(const snapshotKeys& a, const snapshotKeys& b) noexcept
+    {
+        return (a.p_ - b.p_) / static_cast<difference_type>(sizeof(T));
+    }
+private:
+    const unsigned char* p_ {nullptr};
+};
+
+/*
+ *	a whole file, read-only: mapped where mmap exists (pages come in as they are read, nothing is copied),
+ *	read into memory elsewhere
+ */
+class mappedFile
+{
+public:
+    explicit mappedFile(const std::string& path)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd {::open(path.c_str(), O_RDONLY)};
+        if (fd < 0)
+            return;
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            auto p {::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0)};
+            if (p != MAP_FAILED) {
+                data_ = static_cast<const unsigned char*>(p);
+                size_ = static_cast<std::size_t>(st.st_size);
+                ::madvise(p, size_, MADV_SEQUENTIAL);
+            }
+        }
+        ::close(fd);
+#else
+        std::ifstream is(path, std::ios::binary | std::ios::ate);
+        if (!is)
+            return;
+        buffer_.resize(static_cast<std::size_t>(is.tellg()));
+        is.seekg(0);
+        if (is.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(buffer_.size()))) {
+            data_ = buffer_.data();
+            size_ = buffer_.size();
+        }
+#endif
+    }
+    mappedFile(const mappedFile&) = delete;
+    mappedFile& operator=(const mappedFile&) = delete;
+    ~mappedFile()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (data_ != nullptr)
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+    inline const unsigned char* data() const noexcept {return data_;} //nullptr if the file could not be read
+    inline std::size_t size() const noexcept {return size_;}
+private:
+    const unsigned char* data_ {nullptr};
+    std::size_t size_ {};
+#if !(defined(__unix__) || defined(__APPLE__))
+    std::vector<unsigned char> buffer_;
+#endif
+};
+
+/*
+ *	buffered writer of a snapshot, one write call per megabyte
+ *	room for the header is left first, close writes it there once the sections are out (and the count is known)
+ */
+class snapshotWriter
+{
+public:
+    explicit snapshotWriter(const std::string& path) : os_(path, std::ios::binary | std::ios::trunc), buffer_(capacity_)
+    {
+        used_ = sizeof(snapshotHeader);
+    }
+    void write(const void* p, std::size_t n)
+    {
+        if (used_ + n > capacity_)
+            flush();
+        std::memcpy(buffer_.data() + used_, p, n);
+        used_ += n;
+    }
+    bool close(const snapshotHeader& header)
+    {
+        flush();
+        os_.seekp(0);
+        os_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        os_.close();
+        return static_cast<bool>(os_);
+    }
+private:
+    static constexpr std::size_t capacity_ {std::size_t{1} << 20};
+    std::ofstream os_;
+    std::vector<unsigned char> buffer_;
+    std::size_t used_ {};
+    void flush()
+    {
+        os_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(used_));
+        used_ = 0;
+    }
+};
+
+#endif // TREESNAPSHOT_HPP